@@ -0,0 +1,33 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+# Add inputs and outputs from these tool invocations to the build variables 
+C_SRCS += \
+../boot_common/boot_flash.c \
+../boot_common/boot_image.c \
+../boot_common/boot_state.c \
+../boot_common/iap.c 
+
+OBJS += \
+./boot_common/boot_flash.o \
+./boot_common/boot_image.o \
+./boot_common/boot_state.o \
+./boot_common/iap.o 
+
+C_DEPS += \
+./boot_common/boot_flash.d \
+./boot_common/boot_image.d \
+./boot_common/boot_state.d \
+./boot_common/iap.d 
+
+
+# Each subdirectory must supply rules for building sources it contributes
+boot_common/%.o: ../boot_common/%.c
+	@echo 'Building file: $<'
+	@echo 'Invoking: MCU C Compiler'
+	arm-none-eabi-gcc -DDEBUG -D__USE_CMSIS=CMSISv1p30_LPC17xx -D__CODE_RED -D__NEWLIB__ -I"/home/pedro/LPCXpresso/workspace/Lib_CMSISv1p30_LPC17xx/inc" -I"/home/pedro/LPCXpresso/workspace/Lib_EaBaseBoard/inc" -I"/home/pedro/LPCXpresso/workspace/Lib_MCU/inc" -I"../boot_common" -O0 -g3 -Wall -c -fmessage-length=0 -fno-builtin -ffunction-sections -mcpu=cortex-m3 -mthumb -D__NEWLIB__ -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.o)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	@echo 'Finished building: $<'
+	@echo ' '
+
+
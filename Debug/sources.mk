@@ -14,5 +14,6 @@ C_DEPS :=
 
 # Every subdirectory with source files must be described here
 SUBDIRS := \
+boot_common \
 src \
 
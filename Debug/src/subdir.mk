@@ -4,26 +4,44 @@
 
 # Add inputs and outputs from these tool invocations to the build variables 
 C_SRCS += \
+../src/adaptive_rate.c \
+../src/boot_confirm.c \
 ../src/command_ctrl.c \
 ../src/cr_startup_lpc17.c \
-../src/main.c 
+../src/main.c \
+../src/num_string.c \
+../src/sensor_state.c \
+../src/timestamp.c \
+../src/uart_session.c 
 
 OBJS += \
+./src/adaptive_rate.o \
+./src/boot_confirm.o \
 ./src/command_ctrl.o \
 ./src/cr_startup_lpc17.o \
-./src/main.o 
+./src/main.o \
+./src/num_string.o \
+./src/sensor_state.o \
+./src/timestamp.o \
+./src/uart_session.o 
 
 C_DEPS += \
+./src/adaptive_rate.d \
+./src/boot_confirm.d \
 ./src/command_ctrl.d \
 ./src/cr_startup_lpc17.d \
-./src/main.d 
+./src/main.d \
+./src/num_string.d \
+./src/sensor_state.d \
+./src/timestamp.d \
+./src/uart_session.d 
 
 
 # Each subdirectory must supply rules for building sources it contributes
 src/%.o: ../src/%.c
 	@echo 'Building file: $<'
 	@echo 'Invoking: MCU C Compiler'
-	arm-none-eabi-gcc -DDEBUG -D__USE_CMSIS=CMSISv1p30_LPC17xx -D__CODE_RED -D__NEWLIB__ -I"/home/pedro/LPCXpresso/workspace/Lib_CMSISv1p30_LPC17xx/inc" -I"/home/pedro/LPCXpresso/workspace/Lib_EaBaseBoard/inc" -I"/home/pedro/LPCXpresso/workspace/Lib_MCU/inc" -O0 -g3 -Wall -c -fmessage-length=0 -fno-builtin -ffunction-sections -mcpu=cortex-m3 -mthumb -D__NEWLIB__ -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.o)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
+	arm-none-eabi-gcc -DDEBUG -D__USE_CMSIS=CMSISv1p30_LPC17xx -D__CODE_RED -D__NEWLIB__ -I"/home/pedro/LPCXpresso/workspace/Lib_CMSISv1p30_LPC17xx/inc" -I"/home/pedro/LPCXpresso/workspace/Lib_EaBaseBoard/inc" -I"/home/pedro/LPCXpresso/workspace/Lib_MCU/inc" -I"../boot_common" -O0 -g3 -Wall -c -fmessage-length=0 -fno-builtin -ffunction-sections -mcpu=cortex-m3 -mthumb -D__NEWLIB__ -MMD -MP -MF"$(@:%.o=%.d)" -MT"$(@:%.o=%.o)" -MT"$(@:%.o=%.d)" -o "$@" "$<"
 	@echo 'Finished building: $<'
 	@echo ' '
 
@@ -0,0 +1,8 @@
+################################################################################
+# Automatically-generated file. Do not edit!
+################################################################################
+
+USER_OBJS :=
+
+LIBS := -lCMSISv1p30_LPC17xx -lLib_EaBaseBoard -lLib_MCU
+
@@ -0,0 +1,29 @@
+#include "boot_flash.h"
+
+#define SMALL_SECTOR_SIZE 0x1000
+#define SMALL_SECTORS     16
+#define LARGE_SECTOR_SIZE 0x8000
+
+uint32_t boot_flash_sector(uint32_t address)
+{
+	if (address < SMALL_SECTOR_SIZE * SMALL_SECTORS) {
+		return address / SMALL_SECTOR_SIZE;
+	}
+	return SMALL_SECTORS + (address - SMALL_SECTOR_SIZE * SMALL_SECTORS) / LARGE_SECTOR_SIZE;
+}
+
+uint32_t boot_flash_sectorBase(uint32_t sector)
+{
+	if (sector < SMALL_SECTORS) {
+		return sector * SMALL_SECTOR_SIZE;
+	}
+	return SMALL_SECTOR_SIZE * SMALL_SECTORS + (sector - SMALL_SECTORS) * LARGE_SECTOR_SIZE;
+}
+
+uint32_t boot_flash_read32(const boot_flash* flash, uint32_t address)
+{
+	const uint8_t* p = flash->read(flash->ctx, address);
+
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16)
+			| ((uint32_t)p[3] << 24);
+}
@@ -0,0 +1,32 @@
+#ifndef BOOT_FLASH_H__
+#define BOOT_FLASH_H__
+
+#include <stdint.h>
+
+/*
+ * Acesso a flash usado pelo bootloader. Na placa e implementado com IAP
+ * (iap.c); no host, por uma flash simulada em RAM. As funcoes retornam 0
+ * em caso de sucesso.
+ */
+typedef struct boot_flash {
+	//apaga todos os setores que contem [address, address + len)
+	int32_t (*erase)(void* ctx, uint32_t address, uint32_t len);
+	//grava len bytes (multiplo de BOOT_PAGE_SIZE, alinhado) a partir de data em RAM
+	int32_t (*program)(void* ctx, uint32_t address, const uint8_t* data, uint32_t len);
+	//ponteiro para o conteudo da flash em address
+	const uint8_t* (*read)(void* ctx, uint32_t address);
+	void* ctx;
+} boot_flash;
+
+/*
+ * Geometria do LPC1768: setores 0-15 de 4K e 16-29 de 32K.
+ */
+uint32_t boot_flash_sector(uint32_t address);
+uint32_t boot_flash_sectorBase(uint32_t sector);
+
+/*
+ * Le um inteiro de 32 bits little endian da flash.
+ */
+uint32_t boot_flash_read32(const boot_flash* flash, uint32_t address);
+
+#endif
@@ -0,0 +1,100 @@
+#include <string.h>
+
+#include "boot_layout.h"
+#include "boot_image.h"
+
+//tabela de 4 bits: 64 bytes de flash em vez de 1K da tabela completa
+static const uint32_t crcTable[16] = {
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+	0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+	0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+	0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t pageBuf[BOOT_PAGE_SIZE / 4];
+
+uint32_t boot_crc32(uint32_t crc, const uint8_t* data, uint32_t len)
+{
+	uint32_t i;
+
+	crc = ~crc;
+	for (i = 0; i < len; i++) {
+		crc ^= data[i];
+		crc = (crc >> 4) ^ crcTable[crc & 0x0F];
+		crc = (crc >> 4) ^ crcTable[crc & 0x0F];
+	}
+
+	return ~crc;
+}
+
+uint32_t boot_image_crc(const boot_flash* flash, uint32_t base, uint32_t size)
+{
+	uint32_t crc = 0;
+	uint32_t offset;
+	uint32_t len;
+
+	// le em blocos de uma pagina: a flash simulada nao precisa ser contigua
+	for (offset = 0; offset < size; offset += len) {
+		len = size - offset;
+		if (len > BOOT_PAGE_SIZE) {
+			len = BOOT_PAGE_SIZE;
+		}
+		crc = boot_crc32(crc, flash->read(flash->ctx, base + offset), len);
+	}
+
+	return crc;
+}
+
+uint32_t boot_image_vectorsValid(const boot_flash* flash, uint32_t base, uint32_t size)
+{
+	uint32_t stack;
+	uint32_t reset;
+
+	if (size < 8 || size > BOOT_SLOT_SIZE) {
+		return 0;
+	}
+
+	stack = boot_flash_read32(flash, base);
+	reset = boot_flash_read32(flash, base + 4);
+
+	if (!((stack > BOOT_RAM_BASE && stack <= BOOT_RAM_TOP)
+			|| (stack > BOOT_RAM2_BASE && stack <= BOOT_RAM2_TOP))) {
+		return 0;
+	}
+
+	if ((reset & 1) == 0) {
+		return 0; //Cortex-M3 so executa Thumb
+	}
+	reset &= ~1u;
+
+	return reset >= BOOT_APP_BASE && reset < BOOT_APP_BASE + size;
+}
+
+int32_t boot_image_copy(const boot_flash* flash, uint32_t from, uint32_t to, uint32_t size)
+{
+	uint32_t offset;
+	uint32_t len;
+	int32_t status;
+
+	status = flash->erase(flash->ctx, to, size);
+	if (status != 0) {
+		return status;
+	}
+
+	// o IAP so grava a partir da RAM
+	for (offset = 0; offset < size; offset += BOOT_PAGE_SIZE) {
+		len = size - offset;
+		if (len > BOOT_PAGE_SIZE) {
+			len = BOOT_PAGE_SIZE;
+		}
+		memset(pageBuf, 0xFF, sizeof(pageBuf));
+		memcpy(pageBuf, flash->read(flash->ctx, from + offset), len);
+
+		status = flash->program(flash->ctx, to + offset, (const uint8_t*)pageBuf, BOOT_PAGE_SIZE);
+		if (status != 0) {
+			return status;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,32 @@
+#ifndef BOOT_IMAGE_H__
+#define BOOT_IMAGE_H__
+
+#include <stdint.h>
+
+#include "boot_flash.h"
+
+/*
+ * CRC-32 (IEEE 802.3, o mesmo de zlib). Comece com crc = 0 e encadeie as
+ * chamadas para calcular blocos em sequencia.
+ */
+uint32_t boot_crc32(uint32_t crc, const uint8_t* data, uint32_t len);
+
+/*
+ * CRC-32 de size bytes da flash a partir de base.
+ */
+uint32_t boot_image_crc(const boot_flash* flash, uint32_t base, uint32_t size);
+
+/*
+ * Confere a tabela de vetores da imagem em base, ligada para BOOT_APP_BASE:
+ * pilha inicial dentro da RAM e reset handler em Thumb dentro da imagem.
+ * Retorna 1 se for valida.
+ */
+uint32_t boot_image_vectorsValid(const boot_flash* flash, uint32_t base, uint32_t size);
+
+/*
+ * Apaga o destino e copia size bytes de from para to, pagina a pagina.
+ * Retorna 0 em caso de sucesso.
+ */
+int32_t boot_image_copy(const boot_flash* flash, uint32_t from, uint32_t to, uint32_t size);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef BOOT_LAYOUT_H__
+#define BOOT_LAYOUT_H__
+
+/*
+ * Mapa da flash (MFlash512) compartilhado entre o bootloader e a aplicacao.
+ *
+ * 0x00000000 - 0x00003FFF  bootloader            (setores 0-3 de 4K, 16K)
+ * 0x00004000 - 0x00005FFF  estado do boot        (setores 4-5 de 4K, alternados)
+ * 0x00010000 - 0x0002FFFF  aplicacao             (setores 16-19 de 32K, 128K)
+ * 0x00030000 - 0x0004FFFF  imagem recebida       (setores 20-23 de 32K, 128K)
+ * 0x00050000 - 0x0006FFFF  copia da aplicacao    (setores 24-27 de 32K, 128K)
+ *
+ * A aplicacao e ligada em BOOT_APP_BASE (ver rdb1768cmsis_uart_*_memory.ld).
+ */
+
+#define BOOT_LOADER_BASE    0x00000000
+#define BOOT_LOADER_SIZE    0x00004000
+
+#define BOOT_STATE_BASE     0x00004000
+#define BOOT_STATE_SECTOR   0x00001000
+#define BOOT_STATE_SECTORS  2
+
+#define BOOT_SLOT_SIZE      0x00020000
+#define BOOT_APP_BASE       0x00010000
+#define BOOT_DOWNLOAD_BASE  0x00030000
+#define BOOT_BACKUP_BASE    0x00050000
+
+#define BOOT_FLASH_SIZE     0x00080000
+
+//menor escrita aceita pelo IAP
+#define BOOT_PAGE_SIZE      256
+//dados por quadro do protocolo serial (multiplo de BOOT_PAGE_SIZE)
+#define BOOT_CHUNK_SIZE     512
+
+//faixas de RAM aceitas como topo da pilha de uma imagem
+#define BOOT_RAM_BASE       0x10000000
+#define BOOT_RAM_TOP        0x10008000
+#define BOOT_RAM2_BASE      0x2007C000
+#define BOOT_RAM2_TOP       0x20084000
+
+//partidas da imagem nova sem confirmacao antes de voltar para a copia
+#define BOOT_TRIAL_ATTEMPTS 3
+
+#endif
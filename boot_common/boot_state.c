@@ -0,0 +1,119 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "boot_layout.h"
+#include "boot_image.h"
+#include "boot_state.h"
+
+#define BOOT_STATE_MAGIC 0xB0075747
+#define BOOT_STATE_PAGES (BOOT_STATE_SECTOR / BOOT_PAGE_SIZE)
+
+static uint32_t pageBuf[BOOT_PAGE_SIZE / 4];
+
+static uint32_t record_crc(const boot_record* record)
+{
+	return boot_crc32(0, (const uint8_t*)record, offsetof(boot_record, crc));
+}
+
+static uint32_t page_address(uint32_t sector, uint32_t page)
+{
+	return BOOT_STATE_BASE + sector * BOOT_STATE_SECTOR + page * BOOT_PAGE_SIZE;
+}
+
+static uint32_t page_blank(const boot_flash* flash, uint32_t sector, uint32_t page)
+{
+	const uint8_t* p = flash->read(flash->ctx, page_address(sector, page));
+	uint32_t i;
+
+	for (i = 0; i < sizeof(boot_record); i++) {
+		if (p[i] != 0xFF) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/*
+ * Procura o registro mais recente nos setores de estado. Retorna em *sector
+ * o setor dele e, como resultado, a pagina seguinte a ultima usada nesse
+ * setor (BOOT_STATE_PAGES se estiver cheio).
+ */
+static uint32_t find_latest(const boot_flash* flash, boot_record* record,
+		uint32_t* found, uint32_t* sector)
+{
+	boot_record candidate;
+	uint32_t next[BOOT_STATE_SECTORS];
+	uint32_t s;
+	uint32_t page;
+
+	*found = 0;
+	*sector = 0;
+	for (s = 0; s < BOOT_STATE_SECTORS; s++) {
+		next[s] = 0;
+		for (page = 0; page < BOOT_STATE_PAGES; page++) {
+			if (page_blank(flash, s, page)) {
+				continue;
+			}
+			next[s] = page + 1; //paginas com lixo (gravacao interrompida) tambem sao puladas
+
+			memcpy(&candidate, flash->read(flash->ctx, page_address(s, page)),
+					sizeof(candidate));
+			if (candidate.magic != BOOT_STATE_MAGIC || candidate.crc != record_crc(&candidate)) {
+				continue;
+			}
+			if (!*found || candidate.sequence > record->sequence) {
+				*record = candidate;
+				*found = 1;
+				*sector = s;
+			}
+		}
+	}
+
+	return next[*sector];
+}
+
+uint32_t boot_state_read(const boot_flash* flash, boot_record* record)
+{
+	uint32_t found;
+	uint32_t sector;
+
+	find_latest(flash, record, &found, &sector);
+	if (!found) {
+		memset(record, 0, sizeof(*record));
+		record->state = BOOT_STATE_EMPTY;
+		return 1;
+	}
+
+	return 0;
+}
+
+int32_t boot_state_write(const boot_flash* flash, boot_record* record)
+{
+	boot_record latest;
+	uint32_t found;
+	uint32_t sector;
+	uint32_t page;
+	int32_t status;
+
+	page = find_latest(flash, &latest, &found, &sector);
+	if (page >= BOOT_STATE_PAGES) {
+		// setor cheio: o outro so tem registros antigos e pode ser apagado
+		// sem perder o atual
+		sector = (sector + 1) % BOOT_STATE_SECTORS;
+		status = flash->erase(flash->ctx, page_address(sector, 0), BOOT_STATE_SECTOR);
+		if (status != 0) {
+			return status;
+		}
+		page = 0;
+	}
+
+	record->magic = BOOT_STATE_MAGIC;
+	record->sequence = found ? latest.sequence + 1 : 1;
+	record->crc = record_crc(record);
+
+	memset(pageBuf, 0xFF, sizeof(pageBuf));
+	memcpy(pageBuf, record, sizeof(*record));
+
+	return flash->program(flash->ctx, page_address(sector, page),
+			(const uint8_t*)pageBuf, BOOT_PAGE_SIZE);
+}
@@ -0,0 +1,45 @@
+#ifndef BOOT_STATE_H__
+#define BOOT_STATE_H__
+
+#include <stdint.h>
+
+#include "boot_flash.h"
+
+#define BOOT_STATE_EMPTY       0 //nenhum registro: aplicacao gravada pelo debugger
+#define BOOT_STATE_CONFIRMED   1 //aplicacao confirmou que iniciou
+#define BOOT_STATE_TRIAL       2 //imagem nova ainda nao confirmada
+#define BOOT_STATE_ROLLED_BACK 3 //imagem nova falhou, copia anterior restaurada
+
+/*
+ * Registro de estado do boot. Cada alteracao grava um registro novo na
+ * proxima pagina livre de um dos BOOT_STATE_SECTORS setores; o de maior
+ * sequencia vale. Com o setor atual cheio, o registro novo vai para o
+ * outro setor, que e apagado antes: o registro atual so deixa de existir
+ * depois que ha um mais novo gravado.
+ */
+typedef struct boot_record {
+	uint32_t magic;
+	uint32_t sequence;
+	uint32_t state;
+	uint32_t attempts;
+	uint32_t appSize;
+	uint32_t appCrc;
+	uint32_t backupSize;
+	uint32_t backupCrc;
+	uint32_t updateRequested; //aplicacao pediu para aguardar uma atualizacao
+	uint32_t crc;
+} boot_record;
+
+/*
+ * Le o registro mais recente. Sem registro valido, preenche record com
+ * BOOT_STATE_EMPTY e retorna 1; caso contrario retorna 0.
+ */
+uint32_t boot_state_read(const boot_flash* flash, boot_record* record);
+
+/*
+ * Grava record como o registro mais recente (magic, sequence e crc sao
+ * preenchidos aqui). Retorna 0 em caso de sucesso.
+ */
+int32_t boot_state_write(const boot_flash* flash, boot_record* record);
+
+#endif
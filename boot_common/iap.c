@@ -0,0 +1,126 @@
+#include "LPC17xx.h"
+
+#include "boot_layout.h"
+#include "iap.h"
+
+#define IAP_LOCATION 0x1FFF1FF1
+
+#define IAP_CMD_PREPARE 50
+#define IAP_CMD_COPY    51
+#define IAP_CMD_ERASE   52
+
+typedef void (*iap_entry)(uint32_t* command, uint32_t* result);
+
+static uint32_t keepInterrupts = 0;
+
+static int32_t iap_erase(void* ctx, uint32_t address, uint32_t len);
+static int32_t iap_program(void* ctx, uint32_t address, const uint8_t* data, uint32_t len);
+static const uint8_t* iap_read(void* ctx, uint32_t address);
+
+static const boot_flash iapFlash = { iap_erase, iap_program, iap_read, 0 };
+
+/*
+ * Executa um comando IAP. Retorna 0 (CMD_SUCCESS) ou o codigo de erro.
+ */
+static int32_t iap_call(uint32_t* command)
+{
+	uint32_t result[5];
+	uint32_t primask = __get_PRIMASK();
+
+	if (!keepInterrupts) {
+		__disable_irq();
+	}
+
+	// apagar setores de 32K leva centenas de ms: alimenta o watchdog, se
+	// ativo, antes de cada comando (a sequencia nao pode ser interrompida
+	// por outro acesso ao WDT, o que nenhum handler em RAM faz)
+	LPC_WDT->WDFEED = 0xAA;
+	LPC_WDT->WDFEED = 0x55;
+
+	((iap_entry)IAP_LOCATION)(command, result);
+
+	if (!keepInterrupts && !primask) {
+		__enable_irq();
+	}
+
+	return (int32_t)result[0];
+}
+
+static int32_t iap_prepare(uint32_t first, uint32_t last)
+{
+	uint32_t command[5];
+
+	command[0] = IAP_CMD_PREPARE;
+	command[1] = first;
+	command[2] = last;
+
+	return iap_call(command);
+}
+
+static int32_t iap_erase(void* ctx, uint32_t address, uint32_t len)
+{
+	uint32_t command[5];
+	uint32_t first;
+	uint32_t last;
+	int32_t status;
+
+	if (len == 0) {
+		return 0;
+	}
+
+	first = boot_flash_sector(address);
+	last = boot_flash_sector(address + len - 1);
+
+	status = iap_prepare(first, last);
+	if (status != 0) {
+		return status;
+	}
+
+	command[0] = IAP_CMD_ERASE;
+	command[1] = first;
+	command[2] = last;
+	command[3] = SystemCoreClock / 1000;
+
+	return iap_call(command);
+}
+
+static int32_t iap_program(void* ctx, uint32_t address, const uint8_t* data, uint32_t len)
+{
+	uint32_t command[5];
+	uint32_t offset;
+	uint32_t sector;
+	int32_t status;
+
+	for (offset = 0; offset < len; offset += BOOT_PAGE_SIZE) {
+		sector = boot_flash_sector(address + offset);
+
+		status = iap_prepare(sector, sector);
+		if (status != 0) {
+			return status;
+		}
+
+		command[0] = IAP_CMD_COPY;
+		command[1] = address + offset;
+		command[2] = (uint32_t)(data + offset);
+		command[3] = BOOT_PAGE_SIZE;
+		command[4] = SystemCoreClock / 1000;
+
+		status = iap_call(command);
+		if (status != 0) {
+			return status;
+		}
+	}
+
+	return 0;
+}
+
+static const uint8_t* iap_read(void* ctx, uint32_t address)
+{
+	return (const uint8_t*)address;
+}
+
+const boot_flash* iap_flash(uint32_t interruptsInRam)
+{
+	keepInterrupts = interruptsInRam;
+	return &iapFlash;
+}
@@ -0,0 +1,21 @@
+#ifndef IAP_H__
+#define IAP_H__
+
+#include <stdint.h>
+
+#include "boot_flash.h"
+
+/*
+ * Flash do LPC1768 acessada pelas rotinas IAP da ROM.
+ *
+ * Durante uma gravacao a flash nao pode ser lida, entao nenhuma interrupcao
+ * com vetor ou handler em flash pode ocorrer. Com interruptsInRam = 0 as
+ * interrupcoes sao desabilitadas durante cada comando IAP; o bootloader usa
+ * 1 porque move a tabela de vetores e o handler da UART para a RAM.
+ *
+ * O IAP usa os 32 bytes do topo da RAM local: a pilha deve comecar abaixo
+ * deles (ver _vStackTop nos scripts de ligacao).
+ */
+const boot_flash* iap_flash(uint32_t interruptsInRam);
+
+#endif
@@ -0,0 +1,164 @@
+/*****************************************************************************
+ *   Bootloader serial: atualizacao da aplicacao pela UART3 sem debugger.
+ *
+ *   Apos o reset aguarda BOOT_WAIT_MS por um quadro do protocolo
+ *   (boot_proto.h); sem quadro, executa a aplicacao em BOOT_APP_BASE.
+ *   Sem aplicacao valida, ou quando a propria aplicacao pediu a atualizacao
+ *   (comando 'u' do menu serial), permanece aguardando uma atualizacao.
+ *
+ ******************************************************************************/
+
+#include "LPC17xx.h"
+
+#include "boot_layout.h"
+#include "boot_state.h"
+#include "iap.h"
+#include "boot_update.h"
+#include "boot_proto.h"
+#include "boot_uart.h"
+
+#define BOOT_WAIT_MS 500
+
+//WDT no IRC (4 MHz / 4): 1 contagem por microssegundo
+#define BOOT_WATCHDOG_TIMEOUT 4000000
+
+#define SYSTICK_ENABLE    (1UL << 0)
+#define SYSTICK_CLKSOURCE (1UL << 2)
+#define SYSTICK_COUNTFLAG (1UL << 16)
+
+static boot_proto proto;
+static boot_record record;
+
+/*
+ * SysTick sem interrupcao, usado so para contar milissegundos.
+ */
+static void delay_start(void)
+{
+	SysTick->LOAD = SystemCoreClock / 1000 - 1;
+	SysTick->VAL = 0;
+	SysTick->CTRL = SYSTICK_CLKSOURCE | SYSTICK_ENABLE;
+}
+
+static uint32_t delay_tick(void)
+{
+	return (SysTick->CTRL & SYSTICK_COUNTFLAG) != 0;
+}
+
+/*
+ * Sem watchdog ativo nao tem efeito. Com ele ativo (a aplicacao pediu a
+ * atualizacao depois de uma partida em teste), evita o reset durante a
+ * atualizacao.
+ */
+static void watchdog_feed(void)
+{
+	LPC_WDT->WDFEED = 0xAA;
+	LPC_WDT->WDFEED = 0x55;
+}
+
+/*
+ * Arma o watchdog para a partida de uma imagem em teste. Se a aplicacao
+ * travar antes de boot_confirm(), o reset volta para o bootloader.
+ */
+static void watchdog_start(void)
+{
+	LPC_WDT->WDCLKSEL = 0; //IRC
+	LPC_WDT->WDTC = BOOT_WATCHDOG_TIMEOUT;
+	LPC_WDT->WDMOD = 0x03; //WDEN | WDRESET
+	watchdog_feed();
+}
+
+static void pll0_feed(void)
+{
+	LPC_SC->PLL0FEED = 0xAA;
+	LPC_SC->PLL0FEED = 0x55;
+}
+
+/*
+ * Volta o clock para o IRC, como apos o reset: o SystemInit() da aplicacao
+ * reprograma o PLL0 e nao pode encontra-lo ja conectado.
+ */
+static void clock_restore(void)
+{
+	LPC_SC->PLL0CON &= ~(1UL << 1); //desconecta
+	pll0_feed();
+	LPC_SC->PLL0CON = 0; //desabilita
+	pll0_feed();
+
+	LPC_SC->CCLKCFG = 0;
+	LPC_SC->CLKSRCSEL = 0;
+}
+
+static void start_app(uint32_t armWatchdog)
+{
+	const uint32_t* vectors = (const uint32_t*)BOOT_APP_BASE;
+
+	boot_uart_deinit();
+	SysTick->CTRL = 0;
+
+	if (armWatchdog) {
+		watchdog_start();
+	}
+
+	__disable_irq();
+	clock_restore();
+	SCB->VTOR = BOOT_APP_BASE;
+	__enable_irq();
+
+	// troca a pilha e salta para o reset handler sem voltar a usar a pilha antiga
+	__asm volatile ("msr msp, %0\n"
+			"bx %1\n" : : "r" (vectors[0]), "r" (vectors[1]));
+
+	while (1);
+}
+
+/**
+ * Função principal
+ */
+int main(void)
+{
+	uint8_t data[64];
+	uint32_t len;
+	uint32_t elapsed = 0;
+	uint32_t armWatchdog;
+	uint32_t action;
+
+	action = boot_update_select(iap_flash(1), &record, &armWatchdog);
+
+	boot_uart_init();
+	boot_proto_init(&proto, iap_flash(1), &record, boot_uart_send, 0);
+
+	if (action == BOOT_ACTION_RUN_APP) {
+		delay_start();
+		while (elapsed < BOOT_WAIT_MS && proto.frames == 0) {
+			watchdog_feed();
+			len = boot_uart_read(data, sizeof(data));
+			boot_proto_feed(&proto, data, len);
+			if (delay_tick()) {
+				elapsed++;
+			}
+		}
+
+		if (proto.frames == 0) {
+			start_app(armWatchdog);
+		}
+	}
+
+	// modo de atualizacao
+	while (1) {
+		watchdog_feed();
+		len = boot_uart_read(data, sizeof(data));
+		boot_proto_feed(&proto, data, len);
+		boot_proto_service(&proto);
+
+		if (proto.runRequested) {
+			// recomeca pelo reset para contar a partida de uma imagem em teste
+			NVIC_SystemReset();
+		}
+	}
+}
+
+void check_failed(uint8_t *file, uint32_t line)
+{
+	/* Infinite loop */
+	while(1);
+}
@@ -0,0 +1,261 @@
+#include <string.h>
+
+#include "boot_image.h"
+#include "boot_update.h"
+#include "boot_proto.h"
+
+#define RX_HUNT  0
+#define RX_FRAME 1
+
+static uint32_t get_le32(const uint8_t* p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16)
+			| ((uint32_t)p[3] << 24);
+}
+
+static void put_le32(uint8_t* p, uint32_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+	p[2] = (uint8_t)(value >> 16);
+	p[3] = (uint8_t)(value >> 24);
+}
+
+static void respond(boot_proto* proto, uint8_t type, uint8_t seq, uint8_t status)
+{
+	uint8_t resp[1 + BOOT_FRAME_HEADER + 1 + 4];
+
+	resp[0] = BOOT_SOF;
+	resp[1] = type | BOOT_RESP_FLAG;
+	resp[2] = seq;
+	resp[3] = 1;
+	resp[4] = 0;
+	resp[5] = status;
+	put_le32(&resp[6], boot_crc32(0, &resp[1], BOOT_FRAME_HEADER + 1));
+
+	proto->send(proto->sendCtx, resp, sizeof(resp));
+}
+
+static uint8_t handle_start(boot_proto* proto, const uint8_t* payload, uint32_t len)
+{
+	uint32_t size;
+	uint32_t i;
+
+	if (len != 8) {
+		return BOOT_STATUS_LENGTH;
+	}
+
+	size = get_le32(&payload[0]);
+	if (size == 0 || size > BOOT_SLOT_SIZE) {
+		return BOOT_STATUS_LENGTH;
+	}
+
+	for (i = 0; i < BOOT_CHUNK_BUFFERS; i++) {
+		proto->chunks[i].pending = 0;
+	}
+	proto->fillIdx = 0;
+	proto->serviceIdx = 0;
+	proto->active = 0;
+	proto->endDone = 0;
+
+	// apaga tudo antes de confirmar: durante a transferencia so ha gravacoes curtas
+	if (proto->flash->erase(proto->flash->ctx, BOOT_DOWNLOAD_BASE, size) != 0) {
+		return BOOT_STATUS_FLASH;
+	}
+
+	proto->active = 1;
+	proto->status = BOOT_STATUS_OK;
+	proto->imageSize = size;
+	proto->imageCrc = get_le32(&payload[4]);
+	proto->nextOffset = 0;
+	proto->lastOffset = 0;
+
+	return BOOT_STATUS_OK;
+}
+
+static uint8_t handle_data(boot_proto* proto, const uint8_t* payload, uint32_t len)
+{
+	boot_chunk* chunk;
+	uint32_t offset;
+	uint32_t dataLen;
+
+	if (!proto->active) {
+		return BOOT_STATUS_SEQUENCE;
+	}
+	if (proto->status != BOOT_STATUS_OK) {
+		return proto->status;
+	}
+	if (len <= 4 || len > BOOT_PAYLOAD_MAX) {
+		return BOOT_STATUS_LENGTH;
+	}
+
+	offset = get_le32(payload);
+	dataLen = len - 4;
+
+	// resposta anterior perdida: o host reenviou o ultimo bloco aceito
+	if (proto->nextOffset != 0 && offset == proto->lastOffset
+			&& offset + dataLen == proto->nextOffset) {
+		return BOOT_STATUS_OK;
+	}
+
+	if (offset != proto->nextOffset) {
+		return BOOT_STATUS_SEQUENCE;
+	}
+	if (offset + dataLen > proto->imageSize
+			|| (dataLen != BOOT_CHUNK_SIZE && offset + dataLen != proto->imageSize)) {
+		return BOOT_STATUS_LENGTH;
+	}
+
+	chunk = &proto->chunks[proto->fillIdx];
+	if (chunk->pending) {
+		return BOOT_STATUS_BUSY;
+	}
+
+	memset(chunk->data, 0xFF, sizeof(chunk->data));
+	memcpy(chunk->data, &payload[4], dataLen);
+	chunk->offset = offset;
+	chunk->len = dataLen;
+	chunk->pending = 1;
+	proto->fillIdx = (proto->fillIdx + 1) % BOOT_CHUNK_BUFFERS;
+
+	proto->lastOffset = offset;
+	proto->nextOffset = offset + dataLen;
+
+	return BOOT_STATUS_OK;
+}
+
+static uint8_t handle_end(boot_proto* proto)
+{
+	if (!proto->active) {
+		// resposta do END anterior perdida: o host reenviou o END
+		return proto->endDone ? proto->endStatus : BOOT_STATUS_SEQUENCE;
+	}
+
+	while (boot_proto_service(proto)) {
+	}
+
+	if (proto->status != BOOT_STATUS_OK) {
+		return proto->status;
+	}
+	if (proto->nextOffset != proto->imageSize) {
+		return BOOT_STATUS_SEQUENCE;
+	}
+
+	proto->active = 0;
+
+	switch (boot_update_install(proto->flash, proto->record, proto->imageSize, proto->imageCrc)) {
+	case BOOT_UPDATE_OK:
+		proto->endStatus = BOOT_STATUS_OK;
+		break;
+	case BOOT_UPDATE_ERR_IMAGE:
+		proto->endStatus = BOOT_STATUS_IMAGE;
+		break;
+	default:
+		proto->endStatus = BOOT_STATUS_FLASH;
+		break;
+	}
+	proto->endDone = 1;
+
+	return proto->endStatus;
+}
+
+static void handle_frame(boot_proto* proto)
+{
+	uint8_t type = proto->frame[0];
+	uint8_t seq = proto->frame[1];
+	const uint8_t* payload = &proto->frame[BOOT_FRAME_HEADER];
+	uint8_t status;
+
+	if (get_le32(&payload[proto->rxLen])
+			!= boot_crc32(0, proto->frame, BOOT_FRAME_HEADER + proto->rxLen)) {
+		respond(proto, type, seq, BOOT_STATUS_CRC);
+		return;
+	}
+
+	proto->frames++;
+
+	switch (type) {
+	case BOOT_CMD_PING:
+		status = BOOT_STATUS_OK;
+		break;
+	case BOOT_CMD_START:
+		status = handle_start(proto, payload, proto->rxLen);
+		break;
+	case BOOT_CMD_DATA:
+		status = handle_data(proto, payload, proto->rxLen);
+		break;
+	case BOOT_CMD_END:
+		status = handle_end(proto);
+		break;
+	case BOOT_CMD_RUN:
+		status = BOOT_STATUS_OK;
+		proto->runRequested = 1;
+		break;
+	default:
+		status = BOOT_STATUS_COMMAND;
+		break;
+	}
+
+	respond(proto, type, seq, status);
+}
+
+void boot_proto_init(boot_proto* proto, const boot_flash* flash, boot_record* record,
+		void (*send)(void* ctx, const uint8_t* data, uint32_t len), void* sendCtx)
+{
+	memset(proto, 0, sizeof(*proto));
+	proto->flash = flash;
+	proto->record = record;
+	proto->send = send;
+	proto->sendCtx = sendCtx;
+	proto->rxState = RX_HUNT;
+}
+
+void boot_proto_feed(boot_proto* proto, const uint8_t* data, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		if (proto->rxState == RX_HUNT) {
+			if (data[i] == BOOT_SOF) {
+				proto->rxState = RX_FRAME;
+				proto->rxPos = 0;
+			}
+			continue;
+		}
+
+		proto->frame[proto->rxPos++] = data[i];
+
+		if (proto->rxPos == BOOT_FRAME_HEADER) {
+			proto->rxLen = proto->frame[2] | ((uint32_t)proto->frame[3] << 8);
+			if (proto->rxLen > BOOT_PAYLOAD_MAX) {
+				respond(proto, proto->frame[0], proto->frame[1], BOOT_STATUS_LENGTH);
+				proto->rxState = RX_HUNT;
+			}
+		} else if (proto->rxPos > BOOT_FRAME_HEADER
+				&& proto->rxPos == BOOT_FRAME_HEADER + proto->rxLen + 4) {
+			handle_frame(proto);
+			proto->rxState = RX_HUNT;
+		}
+	}
+}
+
+uint32_t boot_proto_service(boot_proto* proto)
+{
+	boot_chunk* chunk = &proto->chunks[proto->serviceIdx];
+	uint32_t len;
+
+	if (!chunk->pending) {
+		return 0;
+	}
+
+	len = (chunk->len + BOOT_PAGE_SIZE - 1) / BOOT_PAGE_SIZE * BOOT_PAGE_SIZE;
+	if (proto->flash->program(proto->flash->ctx, BOOT_DOWNLOAD_BASE + chunk->offset,
+			(const uint8_t*)chunk->data, len) != 0) {
+		proto->status = BOOT_STATUS_FLASH;
+	}
+
+	chunk->pending = 0;
+	proto->serviceIdx = (proto->serviceIdx + 1) % BOOT_CHUNK_BUFFERS;
+
+	return 1;
+}
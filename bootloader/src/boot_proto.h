@@ -0,0 +1,104 @@
+#ifndef BOOT_PROTO_H__
+#define BOOT_PROTO_H__
+
+#include <stdint.h>
+
+#include "boot_layout.h"
+#include "boot_flash.h"
+#include "boot_state.h"
+
+/*
+ * Protocolo de atualizacao pela UART.
+ *
+ * Quadro: SOF (0x7E), tipo, seq, tamanho (16 bits LE), payload,
+ * CRC-32 (LE) de tipo..payload. A resposta usa o mesmo formato com
+ * tipo | BOOT_RESP_FLAG, o seq do comando e 1 byte de status.
+ *
+ *   PING   -                      mantem o bootloader ativo
+ *   START  tamanho u32, crc u32   apaga a area de recepcao
+ *   DATA   offset u32, dados      bloco de ate BOOT_CHUNK_SIZE bytes, em ordem
+ *   END    -                      confere o CRC da imagem e instala; repetido
+ *                                 (resposta perdida), responde o mesmo status
+ *   RUN    -                      reinicia na aplicacao
+ *
+ * Um DATA e confirmado assim que o CRC do quadro confere e ha um buffer
+ * livre; a gravacao acontece em boot_proto_service(), enquanto o proximo
+ * bloco ja esta chegando. Erros de gravacao aparecem no status das
+ * respostas seguintes e no END.
+ */
+
+#define BOOT_SOF        0x7E
+#define BOOT_RESP_FLAG  0x80
+
+#define BOOT_CMD_PING   0x00
+#define BOOT_CMD_START  0x01
+#define BOOT_CMD_DATA   0x02
+#define BOOT_CMD_END    0x03
+#define BOOT_CMD_RUN    0x04
+
+#define BOOT_STATUS_OK        0
+#define BOOT_STATUS_CRC       1 //CRC do quadro invalido
+#define BOOT_STATUS_SEQUENCE  2 //comando fora de ordem ou offset inesperado
+#define BOOT_STATUS_BUSY      3 //sem buffer livre, reenviar
+#define BOOT_STATUS_FLASH     4 //falha ao apagar ou gravar
+#define BOOT_STATUS_IMAGE     5 //CRC ou vetores da imagem invalidos
+#define BOOT_STATUS_LENGTH    6 //tamanho invalido
+#define BOOT_STATUS_COMMAND   7 //comando desconhecido
+
+#define BOOT_FRAME_HEADER   4 //tipo, seq, tamanho
+#define BOOT_PAYLOAD_MAX    (4 + BOOT_CHUNK_SIZE)
+#define BOOT_CHUNK_BUFFERS  2
+
+typedef struct boot_chunk {
+	uint32_t data[BOOT_CHUNK_SIZE / 4]; //alinhado para o IAP
+	uint32_t offset;
+	uint32_t len;
+	uint8_t pending;
+} boot_chunk;
+
+typedef struct boot_proto {
+	const boot_flash* flash;
+	boot_record* record;
+	void (*send)(void* ctx, const uint8_t* data, uint32_t len);
+	void* sendCtx;
+
+	//recepcao do quadro
+	uint8_t rxState;
+	uint32_t rxPos;
+	uint32_t rxLen;
+	uint8_t frame[BOOT_FRAME_HEADER + BOOT_PAYLOAD_MAX + 4];
+
+	//transferencia em andamento
+	uint8_t active;
+	uint8_t status;
+	uint32_t imageSize;
+	uint32_t imageCrc;
+	uint32_t nextOffset;
+	uint32_t lastOffset;
+
+	//resultado da ultima instalacao, para um END repetido
+	uint8_t endDone;
+	uint8_t endStatus;
+
+	boot_chunk chunks[BOOT_CHUNK_BUFFERS];
+	uint32_t fillIdx;
+	uint32_t serviceIdx;
+
+	uint32_t frames;       //quadros validos recebidos
+	uint8_t runRequested;
+} boot_proto;
+
+void boot_proto_init(boot_proto* proto, const boot_flash* flash, boot_record* record,
+		void (*send)(void* ctx, const uint8_t* data, uint32_t len), void* sendCtx);
+
+/*
+ * Processa bytes recebidos. Respostas sao enviadas por send().
+ */
+void boot_proto_feed(boot_proto* proto, const uint8_t* data, uint32_t len);
+
+/*
+ * Grava na flash o proximo bloco pendente, se houver. Retorna 1 se gravou.
+ */
+uint32_t boot_proto_service(boot_proto* proto);
+
+#endif
@@ -0,0 +1,98 @@
+#include "lpc17xx_pinsel.h"
+#include "lpc17xx_uart.h"
+
+#include "boot_uart.h"
+
+#define VECTOR_COUNT    51
+#define UART3_VECTOR    (16 + UART3_IRQn)
+#define RX_BUFFER_SIZE  4096
+
+#define RAMFUNC __attribute__ ((section(".ramfunc")))
+
+extern void (* const g_pfnVectors[])(void);
+
+//VTOR exige alinhamento na potencia de 2 acima do tamanho da tabela
+__attribute__ ((aligned(256)))
+static void (*ramVectors[VECTOR_COUNT])(void);
+
+static volatile uint8_t rxBuffer[RX_BUFFER_SIZE];
+static volatile uint32_t rxHead = 0;
+static volatile uint32_t rxTail = 0;
+
+/*
+ * Executa da RAM e so acessa registradores: pode rodar durante o IAP.
+ */
+RAMFUNC static void boot_uart_irq(void)
+{
+	uint32_t next;
+
+	while (LPC_UART3->LSR & UART_LSR_RDR) {
+		next = (rxHead + 1) % RX_BUFFER_SIZE;
+		if (next == rxTail) {
+			(void)LPC_UART3->RBR; //buffer cheio: o CRC do quadro acusa a perda
+			continue;
+		}
+		rxBuffer[rxHead] = LPC_UART3->RBR;
+		rxHead = next;
+	}
+}
+
+void boot_uart_init(void)
+{
+	PINSEL_CFG_Type PinCfg;
+	UART_CFG_Type uartCfg;
+	uint32_t i;
+
+	/* Initialize UART3 pin connect */
+	PinCfg.Funcnum = 2;
+	PinCfg.OpenDrain = 0;
+	PinCfg.Pinmode = 0;
+	PinCfg.Portnum = 0;
+	PinCfg.Pinnum = 0;
+	PINSEL_ConfigPin(&PinCfg);
+	PinCfg.Pinnum = 1;
+	PINSEL_ConfigPin(&PinCfg);
+
+	uartCfg.Baud_rate = BOOT_BAUD_RATE;
+	uartCfg.Databits = UART_DATABIT_8;
+	uartCfg.Parity = UART_PARITY_NONE;
+	uartCfg.Stopbits = UART_STOPBIT_1;
+
+	UART_Init(LPC_UART3, &uartCfg);
+	UART_TxCmd(LPC_UART3, ENABLE);
+
+	for (i = 0; i < VECTOR_COUNT; i++) {
+		ramVectors[i] = g_pfnVectors[i];
+	}
+	ramVectors[UART3_VECTOR] = boot_uart_irq;
+	SCB->VTOR = (uint32_t)ramVectors;
+
+	UART_IntConfig(LPC_UART3, UART_INTCFG_RBR, ENABLE);
+	NVIC_EnableIRQ(UART3_IRQn);
+}
+
+void boot_uart_deinit(void)
+{
+	NVIC_DisableIRQ(UART3_IRQn);
+	UART_DeInit(LPC_UART3);
+	SCB->VTOR = 0;
+}
+
+uint32_t boot_uart_read(uint8_t* data, uint32_t len)
+{
+	uint32_t count = 0;
+
+	while (count < len && rxTail != rxHead) {
+		data[count++] = rxBuffer[rxTail];
+		rxTail = (rxTail + 1) % RX_BUFFER_SIZE;
+	}
+
+	return count;
+}
+
+void boot_uart_send(void* ctx, const uint8_t* data, uint32_t len)
+{
+	UART_Send(LPC_UART3, (uint8_t*)data, len, BLOCKING);
+	while (UART_CheckBusy(LPC_UART3) == SET) {
+	}
+}
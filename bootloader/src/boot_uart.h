@@ -0,0 +1,30 @@
+#ifndef BOOT_UART_H__
+#define BOOT_UART_H__
+
+#include <stdint.h>
+
+#define BOOT_BAUD_RATE 230400
+
+/*
+ * UART3 do bootloader (P0.0/P0.1). A recepcao e feita por interrupcao em
+ * um buffer circular; a tabela de vetores e o handler ficam na RAM para
+ * que nenhum byte seja perdido enquanto o IAP grava a flash.
+ */
+void boot_uart_init(void);
+
+/*
+ * Desliga a UART3 e a interrupcao e devolve a tabela de vetores para a flash.
+ */
+void boot_uart_deinit(void);
+
+/*
+ * Copia ate len bytes recebidos. Retorna quantos foram copiados.
+ */
+uint32_t boot_uart_read(uint8_t* data, uint32_t len);
+
+/*
+ * Envia len bytes (bloqueante). ctx nao e usado.
+ */
+void boot_uart_send(void* ctx, const uint8_t* data, uint32_t len);
+
+#endif
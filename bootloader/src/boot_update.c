@@ -0,0 +1,126 @@
+#include "boot_layout.h"
+#include "boot_image.h"
+#include "boot_update.h"
+
+/*
+ * Verifica a aplicacao em BOOT_APP_BASE. Sem registro (gravada pelo
+ * debugger) o tamanho e o CRC sao desconhecidos: confere so os vetores.
+ */
+static uint32_t app_valid(const boot_flash* flash, const boot_record* record)
+{
+	if (record->state == BOOT_STATE_EMPTY) {
+		return boot_image_vectorsValid(flash, BOOT_APP_BASE, BOOT_SLOT_SIZE);
+	}
+
+	if (record->appSize == 0) {
+		return 0;
+	}
+
+	return boot_image_vectorsValid(flash, BOOT_APP_BASE, record->appSize)
+			&& boot_image_crc(flash, BOOT_APP_BASE, record->appSize) == record->appCrc;
+}
+
+static int32_t rollback(const boot_flash* flash, boot_record* record)
+{
+	int32_t status = 0;
+
+	if (record->backupSize != 0
+			&& boot_image_crc(flash, BOOT_BACKUP_BASE, record->backupSize) == record->backupCrc) {
+		status = boot_image_copy(flash, BOOT_BACKUP_BASE, BOOT_APP_BASE, record->backupSize);
+		record->appSize = record->backupSize;
+		record->appCrc = record->backupCrc;
+	} else {
+		// sem copia utilizavel: a imagem com falha nao volta a ser executada
+		record->appSize = 0;
+		record->appCrc = 0;
+	}
+
+	record->state = BOOT_STATE_ROLLED_BACK;
+	record->attempts = 0;
+	if (boot_state_write(flash, record) != 0) {
+		status = BOOT_UPDATE_ERR_FLASH;
+	}
+
+	return status;
+}
+
+uint32_t boot_update_select(const boot_flash* flash, boot_record* record,
+		uint32_t* armWatchdog)
+{
+	boot_state_read(flash, record);
+	*armWatchdog = 0;
+
+	if (record->updateRequested) {
+		record->updateRequested = 0;
+		boot_state_write(flash, record);
+		return BOOT_ACTION_STAY;
+	}
+
+	if (record->state == BOOT_STATE_TRIAL) {
+		if (record->attempts >= BOOT_TRIAL_ATTEMPTS) {
+			rollback(flash, record);
+		} else {
+			record->attempts++;
+			boot_state_write(flash, record);
+			*armWatchdog = 1;
+		}
+	}
+
+	// aplicacao corrompida (ex.: energia caiu durante uma instalacao)
+	if (!app_valid(flash, record) && record->backupSize != 0
+			&& record->state != BOOT_STATE_ROLLED_BACK) {
+		rollback(flash, record);
+		*armWatchdog = 0;
+	}
+
+	return app_valid(flash, record) ? BOOT_ACTION_RUN_APP : BOOT_ACTION_STAY;
+}
+
+int32_t boot_update_install(const boot_flash* flash, boot_record* record,
+		uint32_t size, uint32_t crc)
+{
+	if (!boot_image_vectorsValid(flash, BOOT_DOWNLOAD_BASE, size)
+			|| boot_image_crc(flash, BOOT_DOWNLOAD_BASE, size) != crc) {
+		return BOOT_UPDATE_ERR_IMAGE;
+	}
+
+	// uma imagem ainda em teste nao substitui a copia de seguranca
+	if (record->state != BOOT_STATE_TRIAL && app_valid(flash, record)) {
+		if (record->state == BOOT_STATE_EMPTY) {
+			record->appSize = BOOT_SLOT_SIZE;
+			record->appCrc = boot_image_crc(flash, BOOT_APP_BASE, BOOT_SLOT_SIZE);
+		}
+		record->state = BOOT_STATE_CONFIRMED;
+		if (boot_image_copy(flash, BOOT_APP_BASE, BOOT_BACKUP_BASE, record->appSize) != 0
+				|| boot_image_crc(flash, BOOT_BACKUP_BASE, record->appSize) != record->appCrc) {
+			return BOOT_UPDATE_ERR_FLASH;
+		}
+		record->backupSize = record->appSize;
+		record->backupCrc = record->appCrc;
+
+		// registra a copia antes de sobrescrever a aplicacao: se a energia
+		// cair durante a copia, o proximo boot restaura a copia
+		if (boot_state_write(flash, record) != 0) {
+			return BOOT_UPDATE_ERR_FLASH;
+		}
+	}
+
+	if (boot_image_copy(flash, BOOT_DOWNLOAD_BASE, BOOT_APP_BASE, size) != 0
+			|| boot_image_crc(flash, BOOT_APP_BASE, size) != crc) {
+		// a aplicacao foi perdida: o proximo boot volta para a copia
+		record->state = BOOT_STATE_TRIAL;
+		record->attempts = BOOT_TRIAL_ATTEMPTS;
+		boot_state_write(flash, record);
+		return BOOT_UPDATE_ERR_FLASH;
+	}
+
+	record->state = BOOT_STATE_TRIAL;
+	record->attempts = 0;
+	record->appSize = size;
+	record->appCrc = crc;
+	if (boot_state_write(flash, record) != 0) {
+		return BOOT_UPDATE_ERR_FLASH;
+	}
+
+	return BOOT_UPDATE_OK;
+}
@@ -0,0 +1,34 @@
+#ifndef BOOT_UPDATE_H__
+#define BOOT_UPDATE_H__
+
+#include <stdint.h>
+
+#include "boot_flash.h"
+#include "boot_state.h"
+
+#define BOOT_ACTION_RUN_APP 0 //aplicacao valida, pode ser executada
+#define BOOT_ACTION_STAY    1 //sem aplicacao valida ou atualizacao pedida, aguarda atualizacao
+
+#define BOOT_UPDATE_OK          0
+#define BOOT_UPDATE_ERR_IMAGE  -1 //imagem recebida com CRC ou vetores invalidos
+#define BOOT_UPDATE_ERR_FLASH  -2 //falha de gravacao ou verificacao
+
+/*
+ * Decide o que fazer apos o reset. Um pedido de atualizacao da aplicacao
+ * (updateRequested) e consumido aqui e mantem o bootloader aguardando,
+ * entao so vale para um reset. Com uma imagem em teste, conta mais uma
+ * tentativa e pede o watchdog (*armWatchdog = 1); esgotadas as tentativas,
+ * restaura a copia anterior. record recebe o estado resultante.
+ */
+uint32_t boot_update_select(const boot_flash* flash, boot_record* record,
+		uint32_t* armWatchdog);
+
+/*
+ * Instala a imagem de size bytes recebida em BOOT_DOWNLOAD_BASE: guarda a
+ * aplicacao atual em BOOT_BACKUP_BASE (se ela foi confirmada), copia a nova
+ * para BOOT_APP_BASE e grava o estado BOOT_STATE_TRIAL.
+ */
+int32_t boot_update_install(const boot_flash* flash, boot_record* record,
+		uint32_t size, uint32_t crc);
+
+#endif
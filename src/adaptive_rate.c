@@ -0,0 +1,91 @@
+#include <string.h>
+
+#include "adaptive_rate.h"
+
+static uint32_t clamp_interval(const adaptive_rate_cfg* cfg, uint32_t interval)
+{
+	if (interval < cfg->minIntervalMs) {
+		return cfg->minIntervalMs;
+	}
+	if (interval > cfg->maxIntervalMs) {
+		return cfg->maxIntervalMs;
+	}
+	return interval;
+}
+
+/*
+ * Variancia populacional da janela, arredondada para baixo.
+ */
+static uint64_t window_variance(const adaptive_rate* rate)
+{
+	uint64_t sum = 0;
+	uint64_t sumSq = 0;
+	uint64_t mean;
+	uint32_t i;
+
+	if (rate->count < 2) {
+		return 0;
+	}
+
+	for (i = 0; i < rate->count; i++) {
+		sum += rate->window[i];
+	}
+	mean = sum / rate->count;
+
+	for (i = 0; i < rate->count; i++) {
+		uint64_t diff = (rate->window[i] > mean) ?
+				rate->window[i] - mean : mean - rate->window[i];
+		sumSq += diff * diff;
+	}
+
+	return sumSq / rate->count;
+}
+
+void adaptive_rate_init(adaptive_rate* rate, const adaptive_rate_cfg* cfg,
+		uint32_t initialIntervalMs)
+{
+	memset(rate, 0, sizeof(*rate));
+	rate->cfg = *cfg;
+	if (rate->cfg.maxIntervalMs < rate->cfg.minIntervalMs) {
+		rate->cfg.maxIntervalMs = rate->cfg.minIntervalMs;
+	}
+	rate->intervalMs = clamp_interval(&rate->cfg, initialIntervalMs);
+}
+
+uint32_t adaptive_rate_update(adaptive_rate* rate, uint32_t lux, uint64_t ms)
+{
+	uint64_t slope = 0;
+	uint64_t dt;
+	uint32_t delta;
+
+	if (rate->count > 0) {
+		dt = (ms > rate->lastMs) ? ms - rate->lastMs : 1;
+		delta = (lux > rate->lastLux) ? lux - rate->lastLux : rate->lastLux - lux;
+		slope = (uint64_t)delta * 1000 / dt;
+	}
+	rate->lastLux = lux;
+	rate->lastMs = ms;
+
+	rate->window[rate->pos] = lux;
+	rate->pos = (rate->pos + 1) % ADAPTIVE_RATE_WINDOW;
+	if (rate->count < ADAPTIVE_RATE_WINDOW) {
+		rate->count++;
+	}
+
+	if (slope > rate->cfg.slopeThreshold
+			|| window_variance(rate) > rate->cfg.varianceThreshold) {
+		//sinal ativo: amostra o mais rapido permitido
+		rate->intervalMs = rate->cfg.minIntervalMs;
+		rate->quietCount = 0;
+	} else if (++rate->quietCount >= rate->cfg.quietSamples) {
+		//sinal parado: reduz a taxa gradualmente
+		if (rate->intervalMs > rate->cfg.maxIntervalMs / 2) {
+			rate->intervalMs = rate->cfg.maxIntervalMs;
+		} else {
+			rate->intervalMs = clamp_interval(&rate->cfg, rate->intervalMs * 2);
+		}
+		rate->quietCount = 0;
+	}
+
+	return rate->intervalMs;
+}
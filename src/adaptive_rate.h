@@ -0,0 +1,48 @@
+#ifndef ADAPTIVE_RATE_H__
+#define ADAPTIVE_RATE_H__
+
+#include <stdint.h>
+
+#define ADAPTIVE_RATE_WINDOW 8
+
+/*
+ * Limites e limiares do controle de taxa de amostragem.
+ */
+typedef struct adaptive_rate_cfg {
+	uint32_t minIntervalMs;     //intervalo com sinal ativo
+	uint32_t maxIntervalMs;     //intervalo com sinal parado
+	uint32_t slopeThreshold;    //derivada, em lux por segundo
+	uint32_t varianceThreshold; //variancia da janela, em lux^2
+	uint32_t quietSamples;      //amostras calmas antes de dobrar o intervalo
+} adaptive_rate_cfg;
+
+/*
+ * Controle de taxa: vai direto para o intervalo minimo quando a derivada
+ * ou a variancia das ultimas amostras passa do limiar, e dobra o intervalo
+ * (ate o maximo) a cada quietSamples amostras calmas seguidas.
+ * Usa somente aritmetica inteira e nao acessa hardware.
+ */
+typedef struct adaptive_rate {
+	adaptive_rate_cfg cfg;
+
+	uint32_t window[ADAPTIVE_RATE_WINDOW];
+	uint32_t count;
+	uint32_t pos;
+
+	uint32_t lastLux;
+	uint64_t lastMs;
+
+	uint32_t intervalMs;
+	uint32_t quietCount;
+} adaptive_rate;
+
+void adaptive_rate_init(adaptive_rate* rate, const adaptive_rate_cfg* cfg,
+		uint32_t initialIntervalMs);
+
+/*
+ * Registra uma amostra lida no instante ms e retorna o intervalo ate a
+ * proxima leitura.
+ */
+uint32_t adaptive_rate_update(adaptive_rate* rate, uint32_t lux, uint64_t ms);
+
+#endif
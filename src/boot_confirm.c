@@ -0,0 +1,44 @@
+#include "LPC17xx.h"
+
+#include "boot_state.h"
+#include "iap.h"
+
+#include "boot_confirm.h"
+
+void boot_confirm(void)
+{
+	const boot_flash* flash = iap_flash(0);
+	boot_record record;
+
+	boot_state_read(flash, &record);
+	if (record.state != BOOT_STATE_TRIAL) {
+		return;
+	}
+
+	record.state = BOOT_STATE_CONFIRMED;
+	record.attempts = 0;
+	boot_state_write(flash, &record);
+}
+
+void boot_confirm_requestUpdate(void)
+{
+	const boot_flash* flash = iap_flash(0);
+	boot_record record;
+
+	boot_state_read(flash, &record);
+	record.updateRequested = 1;
+	if (boot_state_write(flash, &record) != 0) {
+		return;
+	}
+
+	NVIC_SystemReset();
+}
+
+void boot_confirm_feed(void)
+{
+	// a sequencia de alimentacao nao pode ser interrompida por outro acesso ao WDT
+	__disable_irq();
+	LPC_WDT->WDFEED = 0xAA;
+	LPC_WDT->WDFEED = 0x55;
+	__enable_irq();
+}
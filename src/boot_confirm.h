@@ -0,0 +1,24 @@
+#ifndef BOOT_CONFIRM_H__
+#define BOOT_CONFIRM_H__
+
+/*
+ * Informa ao bootloader que a imagem atual iniciou corretamente. Deve ser
+ * chamada depois da inicializacao dos perifericos; sem ela, uma imagem
+ * nova e substituida pela anterior apos BOOT_TRIAL_ATTEMPTS partidas.
+ */
+void boot_confirm(void);
+
+/*
+ * Alimenta o watchdog armado pelo bootloader na partida de uma imagem em
+ * teste. Sem watchdog ativo nao tem efeito.
+ */
+void boot_confirm_feed(void);
+
+/*
+ * Registra o pedido de atualizacao e reinicia: o bootloader consome o
+ * pedido e aguarda a imagem pela UART3 em vez de executar a aplicacao.
+ * Nao retorna, exceto se o registro nao puder ser gravado.
+ */
+void boot_confirm_requestUpdate(void);
+
+#endif
@@ -143,10 +143,12 @@ extern void _vStackTop(void);
 //
 // The vector table.
 // This relies on the linker script to place at correct location in memory.
+// "used": nothing in C references the table, and with -flto KEEP() in the
+// linker script is not enough to stop it being discarded.
 //
 //*****************************************************************************
 extern void (* const g_pfnVectors[])(void);
-__attribute__ ((section(".isr_vector")))
+__attribute__ ((used, section(".isr_vector")))
 void (* const g_pfnVectors[])(void) = {
 	// Core Level - CM3
 	&_vStackTop, // The initial stack pointer
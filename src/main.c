@@ -17,74 +17,49 @@
 #include "light.h"
 #include "oled.h"
 
-#define UART_DEV LPC_UART3
+#include "timestamp.h"
+#include "sensor_state.h"
+#include "uart_session.h"
+#include "adaptive_rate.h"
+#include "boot_confirm.h"
+#include "num_string.h"
+
+#define SAMPLE_INTERVAL_MS 100
+//ISL29003 com ADC de 12 bits: ~6 ms por conversao. Com 16 bits (padrao do
+//light_init) seriam ~90 ms e o intervalo minimo nao poderia ficar abaixo
+//de 100 ms: leituras mais frequentes so repetiriam a conversao anterior.
+#define LIGHT_WIDTH LIGHT_WIDTH_12BITS
+#define LIGHT_CONVERSION_MS 6
+//intervalo com sinal ativo: acima da conversao, com folga para I2C e OLED
+#define SAMPLE_MIN_INTERVAL_MS 20
+#if SAMPLE_MIN_INTERVAL_MS <= LIGHT_CONVERSION_MS
+#error "SAMPLE_MIN_INTERVAL_MS deve ser maior que o tempo de conversao do sensor"
+#endif
+#define UART_SESSIONS 2
 
-#define RANGE_1000 1
-#define RANGE_4000 2
-#define RANGE_16000 3
-#define RANGE_64000 4
-
-static uint32_t msTicks = 0;
 static uint8_t buf[10];
 
-/**
- * Converte inteiro para String.
- */
-static void intToString(int value, uint8_t* pBuf, uint32_t len, uint32_t base)
-{
-	static const char* pAscii = "0123456789abcdefghijklmnopqrstuvwxyz";
-	int pos = 0;
-	int tmpValue = value;
-
-	// the buffer must not be null and at least have a length of 2 to handle one
-	// digit and null-terminator
-	if (pBuf == NULL || len < 2)
-	{
-		return;
-	}
-
-	// a valid base cannot be less than 2 or larger than 36
-	// a base value of 2 means binary representation. A value of 1 would mean only zeros
-	// a base larger than 36 can only be used if a larger alphabet were used.
-	if (base < 2 || base > 36)
-	{
-		return;
-	}
-
-	// negative value
-	if (value < 0)
-	{
-		tmpValue = -tmpValue;
-		value    = -value;
-		pBuf[pos++] = '-';
-	}
-
-	// calculate the required length of the buffer
-	do {
-		pos++;
-		tmpValue /= base;
-	} while(tmpValue > 0);
-
-
-	if (pos > len)
-	{
-		// the len parameter is invalid.
-		return;
-	}
+static uint32_t uart_port_receive(void* ctx, uint8_t* data, uint32_t len);
+static uint32_t uart_port_send(void* ctx, const uint8_t* data, uint32_t len);
 
-	pBuf[pos] = '\0';
+static const uart_port uart0Port = { uart_port_receive, uart_port_send, (void*)LPC_UART0 };
+static const uart_port uart3Port = { uart_port_receive, uart_port_send, (void*)LPC_UART3 };
 
-	do {
-		pBuf[--pos] = pAscii[value % base];
-		value /= base;
-	} while(value > 0);
+static uart_session sessions[UART_SESSIONS];
 
-	return;
+//limites do controle adaptativo da taxa de amostragem do sensor de luz
+static const adaptive_rate_cfg sampleRateCfg = {
+	SAMPLE_MIN_INTERVAL_MS, //minIntervalMs
+	1000, //maxIntervalMs
+	200,  //slopeThreshold (lux/s)
+	100,  //varianceThreshold (lux^2)
+	4     //quietSamples
+};
 
-}
+static adaptive_rate sampleRate;
 
 void SysTick_Handler(void) {
-	msTicks++;
+	timestamp_tick();
 }
 
 /**
@@ -150,19 +125,20 @@ static void init_i2c(void)
 }
 
 /*
- * Inicializa interface UART
+ * Inicializa uma UART em 115200 8N1.
  * */
-static void init_uart(void)
+static void init_uart_port(LPC_UART_TypeDef* uart, uint8_t funcnum, uint8_t txPin, uint8_t rxPin)
 {
 	PINSEL_CFG_Type PinCfg;
 	UART_CFG_Type uartCfg;
 
-	/* Initialize UART3 pin connect */
-	PinCfg.Funcnum = 2;
-	PinCfg.Pinnum = 0;
+	PinCfg.Funcnum = funcnum;
+	PinCfg.OpenDrain = 0;
+	PinCfg.Pinmode = 0;
 	PinCfg.Portnum = 0;
+	PinCfg.Pinnum = txPin;
 	PINSEL_ConfigPin(&PinCfg);
-	PinCfg.Pinnum = 1;
+	PinCfg.Pinnum = rxPin;
 	PINSEL_ConfigPin(&PinCfg);
 
 	uartCfg.Baud_rate = 115200;
@@ -170,45 +146,59 @@ static void init_uart(void)
 	uartCfg.Parity = UART_PARITY_NONE;
 	uartCfg.Stopbits = UART_STOPBIT_1;
 
-	UART_Init(UART_DEV, &uartCfg);
-
-	UART_TxCmd(UART_DEV, ENABLE);
+	UART_Init(uart, &uartCfg);
 
+	UART_TxCmd(uart, ENABLE);
 }
 
 /*
- * Exibe menu através da comunicação UART.
+ * Inicializa interfaces UART
+ * P0.2/P0.3 - UART0
+ * P0.0/P0.1 - UART3
  * */
-void show_menu(void){
-	UART_SendString(UART_DEV, (uint8_t*)"\n\n********** MENU **********\r\n");
-	UART_SendString(UART_DEV, (uint8_t*)"(1) Ler sensor\r\n");
-	UART_SendString(UART_DEV, (uint8_t*)"(2) Configurar faixa de resposta do sensor de luz para 1000\r\n");
-	UART_SendString(UART_DEV, (uint8_t*)"(3) Configurar faixa de resposta do sensor de luz para 4000\r\n");
-	UART_SendString(UART_DEV, (uint8_t*)"(4) Configurar faixa de resposta do sensor de luz para 16000\r\n");
-	UART_SendString(UART_DEV, (uint8_t*)"(5) Configurar faixa de resposta do sensor de luz para 64000\r\n");
-	UART_SendString(UART_DEV, (uint8_t*)"\r\nDigite uma das opcoes acima: ");
+static void init_uart(void)
+{
+	init_uart_port(LPC_UART0, 1, 2, 3);
+	init_uart_port(LPC_UART3, 2, 0, 1);
+}
+
+static uint32_t uart_port_receive(void* ctx, uint8_t* data, uint32_t len)
+{
+	return UART_Receive((LPC_UART_TypeDef*)ctx, data, len, NONE_BLOCKING);
+}
+
+static uint32_t uart_port_send(void* ctx, const uint8_t* data, uint32_t len)
+{
+	return UART_Send((LPC_UART_TypeDef*)ctx, (uint8_t*)data, len, NONE_BLOCKING);
 }
 
 /*
- * Exibe faixa de valores configurada no sensor através da comunicação UART.
+ * Configura a faixa do sensor de luz. Chamada pela sessao que recebeu o comando.
  * */
-void show_range_selected(uint8_t range){
+static void set_range(uint8_t range)
+{
+	light_shutdown();
+	light_enable();
+	light_setWidth(LIGHT_WIDTH); //reaplica a resolucao depois de religar o sensor
+
 	switch (range) {
 	case RANGE_1000:
-		UART_SendString(UART_DEV, (uint8_t*)"\r\nFaixa atual do sensor configurada = 0 a 1000\r\n");
+		light_setRange(LIGHT_RANGE_1000);
 		break;
 	case RANGE_4000:
-		UART_SendString(UART_DEV, (uint8_t*)"\r\nFaixa atual do sensor configurada = 0 a 4000\r\n");
+		light_setRange(LIGHT_RANGE_4000);
 		break;
 	case RANGE_16000:
-		UART_SendString(UART_DEV, (uint8_t*)"\r\nFaixa atual do sensor configurada = 0 a 16000\r\n");
+		light_setRange(LIGHT_RANGE_16000);
 		break;
 	case RANGE_64000:
-		UART_SendString(UART_DEV, (uint8_t*)"\r\nFaixa atual do sensor configurada = 0 a 64000\r\n");
+		light_setRange(LIGHT_RANGE_64000);
 		break;
 	default:
-		break;
+		return;
 	}
+
+	sensor_state_setRange(range);
 }
 
 /**
@@ -216,11 +206,10 @@ void show_range_selected(uint8_t range){
  */
 int main (void) {
 
-	uint8_t data = 0;
-	uint32_t len = 0;
-	uint8_t menuIsShowing = 0;
-	uint8_t range_selected = 2;
 	uint32_t lux = 0;
+	uint64_t now = 0;
+	uint64_t nextSample = 0;
+	uint32_t i;
 
 	init_i2c();
 	init_ssp();
@@ -229,79 +218,60 @@ int main (void) {
 	oled_init(); //inicializa OLED
 	light_init(); //inicializa sensor de luz
 
-	if (SysTick_Config(SystemCoreClock / 1000)) {
+	if (timestamp_init()) {
 		while (1);  // Capture error
 	}
 
 	light_enable(); //habilita sensor de luz
+	light_setWidth(LIGHT_WIDTH); //conversao rapida, ver LIGHT_CONVERSION_MS
 	light_setRange(LIGHT_RANGE_4000); //seta faixa do sensor de luz para 4000.
+	sensor_state_setRange(RANGE_4000);
 
 	oled_clearScreen(OLED_COLOR_WHITE);
 	oled_putString(1,9,  (uint8_t*)"Light  : ", OLED_COLOR_BLACK, OLED_COLOR_WHITE); //pre configura oled para mostrar valor lido do sensor de luz
 
+	adaptive_rate_init(&sampleRate, &sampleRateCfg, SAMPLE_INTERVAL_MS);
+
+	boot_confirm(); //perifericos inicializados: imagem aceita pelo bootloader
+
+	uart_session_init(&sessions[0], &uart0Port, set_range);
+	uart_session_init(&sessions[1], &uart3Port, set_range);
+
 	//mensagem inicial do sistema
-	UART_SendString(UART_DEV, (uint8_t*)"INATEL - Instituto Nacional de Telecomunicacoes\r\n");
-	UART_SendString(UART_DEV, (uint8_t*)"Disciplina: EC020 - Topicos Especiais em Computacao\r\n");
-	UART_SendString(UART_DEV, (uint8_t*)"Modularizacao de Sistemas Embarcados Usando Orientacao a Objeto\r\n");
+	for (i = 0; i < UART_SESSIONS; i++) {
+		uart_session_print(&sessions[i], "INATEL - Instituto Nacional de Telecomunicacoes\r\n");
+		uart_session_print(&sessions[i], "Disciplina: EC020 - Topicos Especiais em Computacao\r\n");
+		uart_session_print(&sessions[i], "Modularizacao de Sistemas Embarcados Usando Orientacao a Objeto\r\n");
+	}
 
 	while (1) {
-		/* light */
-		lux = light_read();
-		/* output values to OLED display */
-		intToString(lux, buf, 10, 10);
-		oled_fillRect((1+9*6),9, 80, 16, OLED_COLOR_WHITE);
-		oled_putString((1+9*6),9, buf, OLED_COLOR_BLACK, OLED_COLOR_WHITE); //mostra valor lido no display oled
-
-		if (menuIsShowing != 1) { //exibe menu
-			show_range_selected(range_selected);
-			show_menu();
-			menuIsShowing = 1;
+		boot_confirm_feed();
+
+		now = timestamp_ms();
+		if (now >= nextSample) {
+			/* light */
+			lux = light_read();
+			sensor_state_publish(lux, timestamp_now());
+			nextSample = now + adaptive_rate_update(&sampleRate, lux, now);
+			/* output values to OLED display */
+			intToString(lux, buf, 10, 10);
+			oled_fillRect((1+9*6),9, 80, 16, OLED_COLOR_WHITE);
+			oled_putString((1+9*6),9, buf, OLED_COLOR_BLACK, OLED_COLOR_WHITE); //mostra valor lido no display oled
 		}
-		len = UART_Receive(UART_DEV, &data,
-				1, NONE_BLOCKING);
-		if (len > 0) { //se recebeu alguma coisa na UART
-			switch (data) {
-			case '1': //mostra valor lido pelo sensor atraves da UART.
-				UART_SendString(UART_DEV, (uint8_t*)"\r\nValor lido pelo sensor: ");
-				UART_SendString(UART_DEV, (uint8_t*) buf);
-				UART_SendString(UART_DEV, (uint8_t*)" lux");
-				break;
-			case '2': //configura faixa do sensor para 1000.
-				light_shutdown();
-				light_enable();
-				light_setRange(LIGHT_RANGE_1000);
-				UART_SendString(UART_DEV, (uint8_t*)"\r\nSensor configurado para faixa de 0 a 1000.");
-				range_selected = 1;
-				break;
-			case '3': //configura faixa do sensor para 4000.
-				light_shutdown();
-				light_enable();
-				light_setRange(LIGHT_RANGE_4000);
-				UART_SendString(UART_DEV, (uint8_t*)"\r\nSensor configurado para faixa de 0 a 4000.");
-				range_selected = 2;
-				break;
-			case '4': //configura faixa do sensor para 16000.
-				light_shutdown();
-				light_enable();
-				light_setRange(LIGHT_RANGE_16000);
-				UART_SendString(UART_DEV, (uint8_t*)"\r\nSensor configurado para faixa de 0 a 16000.");
-				range_selected = 3;
-				break;
-			case '5'://configura faixa do sensor para 64000.
-				light_shutdown();
-				light_enable();
-				light_setRange(LIGHT_RANGE_64000);
-				UART_SendString(UART_DEV, (uint8_t*)"\r\nSensor configurado para faixa de 0 a 64000.");
-				range_selected = 4;
-				break;
-			default: //comando inválido.
-				UART_SendString(UART_DEV, (uint8_t*)"\r\nError - Opcao invalida!!");
-				break;
-			}
 
-			menuIsShowing = 0;
+		//atende as sessoes sem bloquear
+		for (i = 0; i < UART_SESSIONS; i++) {
+			uart_session_poll(&sessions[i]);
+		}
+
+		//pedido de atualizacao: reinicia no bootloader depois de enviar a resposta
+		for (i = 0; i < UART_SESSIONS; i++) {
+			if (sessions[i].updateRequested && uart_session_txIdle(&sessions[i])) {
+				while (UART_CheckBusy((LPC_UART_TypeDef*)sessions[i].port->ctx) == SET);
+				boot_confirm_requestUpdate();
+				sessions[i].updateRequested = 0; //registro nao gravado: segue na aplicacao
+			}
 		}
-		Timer0_Wait(100);
 	}
 
 
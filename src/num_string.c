@@ -0,0 +1,87 @@
+#include <stddef.h>
+
+#include "num_string.h"
+
+/**
+ * Converte inteiro para String.
+ */
+void intToString(int value, uint8_t* pBuf, uint32_t len, uint32_t base)
+{
+	static const char* pAscii = "0123456789abcdefghijklmnopqrstuvwxyz";
+	int pos = 0;
+	int tmpValue = value;
+
+	// the buffer must not be null and at least have a length of 2 to handle one
+	// digit and null-terminator
+	if (pBuf == NULL || len < 2)
+	{
+		return;
+	}
+
+	// a valid base cannot be less than 2 or larger than 36
+	// a base value of 2 means binary representation. A value of 1 would mean only zeros
+	// a base larger than 36 can only be used if a larger alphabet were used.
+	if (base < 2 || base > 36)
+	{
+		return;
+	}
+
+	// negative value
+	if (value < 0)
+	{
+		tmpValue = -tmpValue;
+		value    = -value;
+		pBuf[pos++] = '-';
+	}
+
+	// calculate the required length of the buffer
+	do {
+		pos++;
+		tmpValue /= base;
+	} while(tmpValue > 0);
+
+
+	if ((uint32_t)pos > len)
+	{
+		// the len parameter is invalid.
+		return;
+	}
+
+	pBuf[pos] = '\0';
+
+	do {
+		pBuf[--pos] = pAscii[value % base];
+		value /= base;
+	} while(value > 0);
+
+	return;
+
+}
+
+uint32_t uintToString(uint32_t value, uint8_t* pBuf, uint32_t len)
+{
+	uint8_t digits[10];
+	uint32_t count = 0;
+	uint32_t i;
+
+	if (pBuf == NULL || len < 2) {
+		return 0;
+	}
+
+	do {
+		digits[count++] = '0' + (uint8_t)(value % 10);
+		value /= 10;
+	} while (value > 0);
+
+	if (count + 1 > len) {
+		pBuf[0] = '\0';
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		pBuf[i] = digits[count - 1 - i];
+	}
+	pBuf[count] = '\0';
+
+	return count;
+}
@@ -0,0 +1,17 @@
+#ifndef NUM_STRING_H__
+#define NUM_STRING_H__
+
+#include <stdint.h>
+
+/**
+ * Converte inteiro para String.
+ */
+void intToString(int value, uint8_t* pBuf, uint32_t len, uint32_t base);
+
+/*
+ * Converte um inteiro sem sinal para String decimal. Retorna o numero de
+ * caracteres escritos (sem o terminador) ou 0 se o buffer for pequeno demais.
+ */
+uint32_t uintToString(uint32_t value, uint8_t* pBuf, uint32_t len);
+
+#endif
@@ -0,0 +1,34 @@
+#include "sensor_state.h"
+
+//numero de sequencia: impar enquanto uma escrita esta em andamento
+static volatile uint32_t sequence = 0;
+static volatile uint32_t stateLux = 0;
+static volatile timestamp_t stateTimestamp = 0;
+static volatile uint8_t stateRange = RANGE_4000;
+
+void sensor_state_publish(uint32_t lux, timestamp_t timestamp)
+{
+	sequence++;
+	stateLux = lux;
+	stateTimestamp = timestamp;
+	sequence++;
+}
+
+void sensor_state_setRange(uint8_t range)
+{
+	sequence++;
+	stateRange = range;
+	sequence++;
+}
+
+void sensor_state_snapshot(sensor_sample* sample)
+{
+	uint32_t seq;
+
+	do {
+		seq = sequence;
+		sample->lux = stateLux;
+		sample->timestamp = stateTimestamp;
+		sample->range = stateRange;
+	} while ((seq & 1) != 0 || seq != sequence);
+}
@@ -0,0 +1,40 @@
+#ifndef SENSOR_STATE_H__
+#define SENSOR_STATE_H__
+
+#include <stdint.h>
+
+#include "timestamp.h"
+
+#define RANGE_1000 1
+#define RANGE_4000 2
+#define RANGE_16000 3
+#define RANGE_64000 4
+
+/*
+ * Ultima amostra do sensor de luz, compartilhada entre todas as sessoes UART.
+ */
+typedef struct sensor_sample {
+	uint32_t lux;
+	timestamp_t timestamp;
+	uint8_t range;
+} sensor_sample;
+
+/*
+ * Publica uma nova leitura. Deve existir um unico contexto escritor, que
+ * pode ser o loop principal ou uma ISR.
+ */
+void sensor_state_publish(uint32_t lux, timestamp_t timestamp);
+
+/*
+ * Registra a faixa configurada no sensor.
+ */
+void sensor_state_setRange(uint8_t range);
+
+/*
+ * Copia o estado atual. A copia e sempre consistente: se uma escrita
+ * interromper a leitura, a copia e refeita. Nao deve ser chamada de um
+ * contexto que interrompa o escritor.
+ */
+void sensor_state_snapshot(sensor_sample* sample);
+
+#endif
@@ -0,0 +1,173 @@
+#include "LPC17xx.h"
+
+#include "timestamp.h"
+
+#define ICSR_PENDSTSET (1UL << 26)
+#define SHCSR_SYSTICKACT (1UL << 11)
+
+//nos testes de host, simula a preempcao entre os acessos ao contador
+#ifndef TIMESTAMP_PREEMPT_POINT
+#define TIMESTAMP_PREEMPT_POINT()
+#endif
+
+/*
+ * Contador de milissegundos em duas copias, escrito somente pelo
+ * SysTick_Handler. Com "generation" par a copia valida e a 0; com
+ * "generation" impar, a 1. O escritor sempre altera a copia que nao esta
+ * valida, entao um leitor que interrompe o SysTick_Handler le a outra copia
+ * sem esperar por ele; um leitor interrompido pelo SysTick_Handler ve
+ * "generation" mudar e refaz a leitura. Com "generation" impar o SysTick ja
+ * ocorreu e a copia 1 ainda tem o valor anterior, por isso o leitor soma 1.
+ */
+static volatile uint32_t generation = 0;
+static volatile uint64_t msCount[2] = { 0, 0 };
+
+/*
+ * Um leitor que interrompe o SysTick_Handler antes da primeira instrucao
+ * ve "generation" par e o valor antigo, mas o contador ja recarregou e a
+ * flag de pendencia ja foi limpa na entrada da excecao. Com o SysTick ativo
+ * (SHCSR) e tickApplied em 0, o leitor soma o milissegundo ainda nao
+ * contado. tickApplied volta a 0 no fim do handler com FAULTMASK ativo, que
+ * o retorno da excecao desativa: nenhuma ISR ve o handler ativo com
+ * tickApplied em 0 depois da contagem.
+ */
+static volatile uint32_t tickApplied = 0;
+
+static uint32_t ticksPerUs = 1;
+
+uint32_t timestamp_init(void)
+{
+	ticksPerUs = SystemCoreClock / 1000000;
+	if (ticksPerUs == 0) {
+		ticksPerUs = 1;
+	}
+
+	return SysTick_Config(SystemCoreClock / 1000);
+}
+
+void timestamp_tick(void)
+{
+	uint64_t next = msCount[0] + 1;
+
+	TIMESTAMP_PREEMPT_POINT();
+	generation++; //impar: leitores usam a copia 1
+	TIMESTAMP_PREEMPT_POINT();
+	tickApplied = 1; //antes de "generation" voltar a par
+	TIMESTAMP_PREEMPT_POINT();
+	msCount[0] = next;
+	TIMESTAMP_PREEMPT_POINT();
+	generation++; //par: leitores usam a copia 0
+	TIMESTAMP_PREEMPT_POINT();
+	msCount[1] = next;
+	TIMESTAMP_PREEMPT_POINT();
+
+	__disable_fault_irq(); //desativada no retorno da excecao
+	tickApplied = 0;
+}
+
+/*
+ * Milissegundos do contador a partir de uma leitura de "generation",
+ * incluindo o tick em que o SysTick_Handler entrou mas ainda nao contou.
+ */
+static uint64_t read_ms(uint32_t gen)
+{
+	uint64_t ms = msCount[gen & 1] + (gen & 1);
+
+	if ((gen & 1) == 0 && (SCB->SHCSR & SHCSR_SYSTICKACT) && !tickApplied) {
+		ms++;
+	}
+
+	return ms;
+}
+
+uint64_t timestamp_ms(void)
+{
+	uint32_t gen;
+	uint64_t ms;
+
+	do {
+		gen = generation;
+		TIMESTAMP_PREEMPT_POINT();
+		ms = read_ms(gen);
+		TIMESTAMP_PREEMPT_POINT();
+	} while (gen != generation);
+
+	return ms;
+}
+
+timestamp_t timestamp_compose(uint64_t ms, uint32_t reload, uint32_t current,
+		uint32_t pending, uint32_t ticksPerUs)
+{
+	uint32_t us;
+
+	if (current > reload) {
+		current = reload;
+	}
+	if (ticksPerUs == 0) {
+		ticksPerUs = 1;
+	}
+
+	// o SysTick decrementa de reload ate 0
+	us = (reload - current) / ticksPerUs;
+	if (us > 999) {
+		us = 999;
+	}
+
+	if (pending) {
+		ms++;
+	}
+
+	return ms * 1000 + us;
+}
+
+timestamp_t timestamp_now(void)
+{
+	uint32_t gen;
+	uint64_t ms;
+	uint32_t current;
+	uint32_t pending;
+
+	do {
+		gen = generation;
+		TIMESTAMP_PREEMPT_POINT();
+		ms = read_ms(gen);
+		current = SysTick->VAL;
+		pending = SCB->ICSR & ICSR_PENDSTSET;
+		if (pending) {
+			// o contador recarregou antes da leitura da flag; relê para
+			// obter um valor posterior a recarga
+			current = SysTick->VAL;
+		}
+		TIMESTAMP_PREEMPT_POINT();
+	} while (gen != generation);
+
+	return timestamp_compose(ms, SysTick->LOAD, current, pending != 0, ticksPerUs);
+}
+
+uint32_t timestamp_toString(timestamp_t value, uint8_t* pBuf, uint32_t len)
+{
+	uint8_t digits[20];
+	uint32_t count = 0;
+	uint32_t i;
+
+	if (pBuf == 0 || len < 2) {
+		return 0;
+	}
+
+	do {
+		digits[count++] = '0' + (uint8_t)(value % 10);
+		value /= 10;
+	} while (value > 0);
+
+	if (count + 1 > len) {
+		pBuf[0] = '\0';
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		pBuf[i] = digits[count - 1 - i];
+	}
+	pBuf[count] = '\0';
+
+	return count;
+}
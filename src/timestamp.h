@@ -0,0 +1,55 @@
+#ifndef TIMESTAMP_H__
+#define TIMESTAMP_H__
+
+#include <stdint.h>
+
+/*
+ * Base de tempo monotonica de 64 bits, em microssegundos desde o boot.
+ *
+ * Os milissegundos vem do contador incrementado no SysTick_Handler e a
+ * fracao de milissegundo vem do registrador SysTick->VAL, que decrementa
+ * a cada ciclo do core. A leitura nao desabilita interrupcoes: o contador
+ * de 64 bits e mantido em duas copias com um contador de geracao, entao a
+ * leitura e consistente mesmo de uma ISR que interrompa o SysTick_Handler
+ * no meio da atualizacao.
+ */
+typedef uint64_t timestamp_t;
+
+/*
+ * Configura o SysTick para 1 ms. Retorna 0 em caso de sucesso.
+ */
+uint32_t timestamp_init(void);
+
+/*
+ * Deve ser chamada a cada interrupcao do SysTick, como ultima acao do
+ * SysTick_Handler: termina com FAULTMASK ativo, que o retorno da excecao
+ * desativa.
+ */
+void timestamp_tick(void);
+
+/*
+ * Milissegundos desde o boot.
+ */
+uint64_t timestamp_ms(void);
+
+/*
+ * Microssegundos desde o boot. Pode ser chamada de ISRs e do loop principal.
+ */
+timestamp_t timestamp_now(void);
+
+/*
+ * Combina o contador de milissegundos com o valor atual do SysTick.
+ * "pending" indica que o SysTick ja recarregou mas a interrupcao ainda nao
+ * foi atendida (leitura feita com prioridade maior que a do SysTick).
+ * Nao acessa hardware.
+ */
+timestamp_t timestamp_compose(uint64_t ms, uint32_t reload, uint32_t current,
+		uint32_t pending, uint32_t ticksPerUs);
+
+/*
+ * Converte um timestamp para String decimal. Retorna o numero de caracteres
+ * escritos (sem o terminador) ou 0 se o buffer for pequeno demais.
+ */
+uint32_t timestamp_toString(timestamp_t value, uint8_t* pBuf, uint32_t len);
+
+#endif
@@ -0,0 +1,288 @@
+#include <string.h>
+
+#include "uart_session.h"
+#include "sensor_state.h"
+#include "num_string.h"
+#include "timestamp.h"
+
+#define SAMPLE_PAYLOAD_LEN 13
+
+static const char* rangeNames[] = { "", "1000", "4000", "16000", "64000" };
+
+static uint32_t txq_free(const uart_session* session)
+{
+	return (session->txTail + UART_SESSION_TXQ_SIZE - session->txHead - 1)
+			% UART_SESSION_TXQ_SIZE;
+}
+
+/*
+ * Enfileira len bytes, ou nenhum se nao houver espaco.
+ */
+static uint32_t txq_put(uart_session* session, const uint8_t* data, uint32_t len)
+{
+	uint32_t i;
+
+	if (len > txq_free(session)) {
+		session->txDropped++;
+		return 0;
+	}
+
+	for (i = 0; i < len; i++) {
+		session->txq[session->txHead] = data[i];
+		session->txHead = (session->txHead + 1) % UART_SESSION_TXQ_SIZE;
+	}
+
+	return 1;
+}
+
+static void txq_flush(uart_session* session)
+{
+	uint32_t chunk;
+	uint32_t sent;
+
+	while (session->txHead != session->txTail) {
+		if (session->txHead > session->txTail) {
+			chunk = session->txHead - session->txTail;
+		} else {
+			chunk = UART_SESSION_TXQ_SIZE - session->txTail;
+		}
+
+		sent = session->port->send(session->port->ctx,
+				&session->txq[session->txTail], chunk);
+		session->txTail = (session->txTail + sent) % UART_SESSION_TXQ_SIZE;
+
+		if (sent < chunk) {
+			break; //FIFO da UART cheia, continua na proxima chamada
+		}
+	}
+}
+
+static void put_le(uint8_t* pBuf, uint64_t value, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		pBuf[i] = (uint8_t)(value >> (8 * i));
+	}
+}
+
+static void send_frame(uart_session* session, uint8_t type,
+		const uint8_t* payload, uint8_t len)
+{
+	uint8_t frame[UART_SESSION_FRAME_HEADER + SAMPLE_PAYLOAD_LEN + 1];
+	uint8_t checksum;
+	uint32_t i;
+
+	frame[0] = UART_SESSION_FRAME_SOF;
+	frame[1] = type;
+	frame[2] = len;
+	put_le(&frame[3], timestamp_now(), 8);
+	memcpy(&frame[UART_SESSION_FRAME_HEADER], payload, len);
+
+	checksum = 0;
+	for (i = 1; i < UART_SESSION_FRAME_HEADER + (uint32_t)len; i++) {
+		checksum ^= frame[i];
+	}
+	frame[UART_SESSION_FRAME_HEADER + len] = checksum;
+
+	txq_put(session, frame, UART_SESSION_FRAME_HEADER + 1u + len);
+}
+
+/*
+ * Exibe menu.
+ */
+static void show_menu(uart_session* session)
+{
+	uart_session_print(session, "\n\n********** MENU **********\r\n");
+	uart_session_print(session, "(1) Ler sensor\r\n");
+	uart_session_print(session, "(2) Configurar faixa de resposta do sensor de luz para 1000\r\n");
+	uart_session_print(session, "(3) Configurar faixa de resposta do sensor de luz para 4000\r\n");
+	uart_session_print(session, "(4) Configurar faixa de resposta do sensor de luz para 16000\r\n");
+	uart_session_print(session, "(5) Configurar faixa de resposta do sensor de luz para 64000\r\n");
+	uart_session_print(session, "(t) Saida em texto / (b) Saida binaria\r\n");
+	uart_session_print(session, "(u) Reiniciar no bootloader para atualizacao\r\n");
+	uart_session_print(session, "\r\nDigite uma das opcoes acima e pressione Enter: ");
+}
+
+/*
+ * Exibe faixa de valores configurada no sensor.
+ */
+static void show_range_selected(uart_session* session, uint8_t range)
+{
+	if (range < RANGE_1000 || range > RANGE_64000) {
+		return;
+	}
+	uart_session_print(session, "\r\nFaixa atual do sensor configurada = 0 a ");
+	uart_session_print(session, rangeNames[range]);
+	uart_session_print(session, "\r\n");
+}
+
+static void send_sample(uart_session* session)
+{
+	sensor_sample sample;
+	uint8_t payload[SAMPLE_PAYLOAD_LEN];
+	uint8_t text[21];
+
+	sensor_state_snapshot(&sample);
+
+	if (session->mode == UART_SESSION_BINARY) {
+		put_le(&payload[0], sample.timestamp, 8);
+		put_le(&payload[8], sample.lux, 4);
+		payload[12] = sample.range;
+		send_frame(session, UART_SESSION_FRAME_SAMPLE, payload, SAMPLE_PAYLOAD_LEN);
+		return;
+	}
+
+	uart_session_print(session, "\r\nValor lido pelo sensor: ");
+	uintToString(sample.lux, text, sizeof(text));
+	uart_session_print(session, (const char*)text);
+	uart_session_print(session, " lux @ ");
+	timestamp_toString(sample.timestamp, text, sizeof(text));
+	uart_session_print(session, (const char*)text);
+	uart_session_print(session, " us");
+}
+
+static void select_range(uart_session* session, uint8_t range)
+{
+	if (session->setRange != 0) {
+		session->setRange(range);
+	}
+
+	if (session->mode == UART_SESSION_BINARY) {
+		send_frame(session, UART_SESSION_FRAME_RANGE, &range, 1);
+		return;
+	}
+
+	uart_session_print(session, "\r\nSensor configurado para faixa de 0 a ");
+	uart_session_print(session, rangeNames[range]);
+	uart_session_print(session, ".");
+}
+
+static void send_error(uart_session* session)
+{
+	uint8_t code = 0;
+
+	if (session->mode == UART_SESSION_BINARY) {
+		send_frame(session, UART_SESSION_FRAME_ERROR, &code, 1);
+		return;
+	}
+
+	uart_session_print(session, "\r\nError - Opcao invalida!!");
+}
+
+static void handle_line(uart_session* session)
+{
+	uint8_t mode;
+	uint8_t accepted = 1;
+
+	if (session->lineLen != 1) {
+		send_error(session);
+		session->menuIsShowing = 0;
+		return;
+	}
+
+	switch (session->line[0]) {
+	case '1': //envia valor lido pelo sensor.
+		send_sample(session);
+		break;
+	case '2': //configura faixa do sensor para 1000.
+		select_range(session, RANGE_1000);
+		break;
+	case '3': //configura faixa do sensor para 4000.
+		select_range(session, RANGE_4000);
+		break;
+	case '4': //configura faixa do sensor para 16000.
+		select_range(session, RANGE_16000);
+		break;
+	case '5': //configura faixa do sensor para 64000.
+		select_range(session, RANGE_64000);
+		break;
+	case 't': //saida em texto.
+	case 'b': //saida binaria.
+		session->mode = (session->line[0] == 'b') ? UART_SESSION_BINARY : UART_SESSION_TEXT;
+		if (session->mode == UART_SESSION_BINARY) {
+			mode = session->mode;
+			send_frame(session, UART_SESSION_FRAME_MODE, &mode, 1);
+		} else {
+			uart_session_print(session, "\r\nSaida em texto.");
+		}
+		break;
+	case 'u': //reinicia no bootloader.
+		session->updateRequested = 1;
+		if (session->mode == UART_SESSION_BINARY) {
+			send_frame(session, UART_SESSION_FRAME_UPDATE, &accepted, 1);
+		} else {
+			uart_session_print(session, "\r\nReiniciando no bootloader...\r\n");
+		}
+		break;
+	default: //comando invalido.
+		send_error(session);
+		break;
+	}
+
+	session->menuIsShowing = 0;
+}
+
+static void receive_byte(uart_session* session, uint8_t data)
+{
+	if (data == '\r' || data == '\n') {
+		if (session->lineOverflow) {
+			send_error(session);
+			session->menuIsShowing = 0;
+		} else if (session->lineLen > 0) {
+			handle_line(session);
+		}
+		session->lineLen = 0;
+		session->lineOverflow = 0;
+		return;
+	}
+
+	if (session->lineLen < UART_SESSION_LINE_MAX) {
+		session->line[session->lineLen++] = data;
+	} else {
+		session->lineOverflow = 1; //descarta ate o fim da linha
+	}
+}
+
+void uart_session_init(uart_session* session, const uart_port* port,
+		void (*setRange)(uint8_t range))
+{
+	memset(session, 0, sizeof(*session));
+	session->port = port;
+	session->setRange = setRange;
+	session->mode = UART_SESSION_TEXT;
+}
+
+void uart_session_poll(uart_session* session)
+{
+	uint8_t data[16];
+	uint32_t len;
+	uint32_t i;
+	sensor_sample sample;
+
+	if (session->mode == UART_SESSION_TEXT && session->menuIsShowing != 1) {
+		sensor_state_snapshot(&sample);
+		show_range_selected(session, sample.range);
+		show_menu(session);
+		session->menuIsShowing = 1;
+	}
+
+	do {
+		len = session->port->receive(session->port->ctx, data, sizeof(data));
+		for (i = 0; i < len; i++) {
+			receive_byte(session, data[i]);
+		}
+	} while (len == sizeof(data));
+
+	txq_flush(session);
+}
+
+uint32_t uart_session_print(uart_session* session, const char* str)
+{
+	return txq_put(session, (const uint8_t*)str, strlen(str));
+}
+
+uint32_t uart_session_txIdle(const uart_session* session)
+{
+	return session->txHead == session->txTail;
+}
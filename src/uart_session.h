@@ -0,0 +1,79 @@
+#ifndef UART_SESSION_H__
+#define UART_SESSION_H__
+
+#include <stdint.h>
+
+#define UART_SESSION_LINE_MAX 16
+#define UART_SESSION_TXQ_SIZE 1024
+
+#define UART_SESSION_TEXT 0
+#define UART_SESSION_BINARY 1
+
+//quadros do modo binario: SOF, tipo, tamanho do payload, timestamp do envio
+//(u64, us, little endian), payload, checksum (XOR de tipo..payload)
+#define UART_SESSION_FRAME_SOF 0x7E
+#define UART_SESSION_FRAME_HEADER 11
+#define UART_SESSION_FRAME_SAMPLE 0x01
+#define UART_SESSION_FRAME_RANGE 0x02
+#define UART_SESSION_FRAME_MODE 0x03
+#define UART_SESSION_FRAME_UPDATE 0x04
+#define UART_SESSION_FRAME_ERROR 0x7F
+
+/*
+ * Acesso nao bloqueante a uma porta serial. Na placa, encapsula
+ * UART_Receive/UART_Send; no host, pode ser um link serial simulado.
+ */
+typedef struct uart_port {
+	//le ate len bytes disponiveis, retorna quantos foram lidos
+	uint32_t (*receive)(void* ctx, uint8_t* data, uint32_t len);
+	//envia ate len bytes sem bloquear, retorna quantos foram aceitos
+	uint32_t (*send)(void* ctx, const uint8_t* data, uint32_t len);
+	void* ctx;
+} uart_port;
+
+/*
+ * Sessao de comandos de uma porta: parser de linhas, fila de transmissao
+ * e modo de saida proprios. O estado do sensor e compartilhado entre as
+ * sessoes atraves de sensor_state.
+ */
+typedef struct uart_session {
+	const uart_port* port;
+	//aplica uma nova faixa no sensor; chamada pela sessao que recebeu o comando
+	void (*setRange)(uint8_t range);
+
+	uint8_t mode;
+	uint8_t menuIsShowing;
+	//comando 'u' recebido: main reinicia no bootloader quando a fila esvaziar
+	uint8_t updateRequested;
+
+	uint8_t line[UART_SESSION_LINE_MAX];
+	uint32_t lineLen;
+	uint8_t lineOverflow;
+
+	uint8_t txq[UART_SESSION_TXQ_SIZE];
+	uint32_t txHead;
+	uint32_t txTail;
+	uint32_t txDropped;
+} uart_session;
+
+void uart_session_init(uart_session* session, const uart_port* port,
+		void (*setRange)(uint8_t range));
+
+/*
+ * Processa os bytes recebidos e envia o que couber da fila de transmissao.
+ * Nunca bloqueia; deve ser chamada a cada iteracao do loop principal.
+ */
+void uart_session_poll(uart_session* session);
+
+/*
+ * Enfileira uma String para transmissao. Mensagens que nao cabem na fila
+ * sao descartadas inteiras (contadas em txDropped). Retorna 1 se enfileirou.
+ */
+uint32_t uart_session_print(uart_session* session, const char* str);
+
+/*
+ * Retorna 1 quando toda a fila de transmissao foi entregue a porta.
+ */
+uint32_t uart_session_txIdle(const uart_session* session);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef CHECK_H__
+#define CHECK_H__
+
+#include <stdio.h>
+
+/*
+ * Verificacoes minimas para os testes de host. Cada teste e um executavel;
+ * main retorna check_result().
+ */
+static int checkFailures = 0;
+
+#define CHECK(cond) do { \
+	if (!(cond)) { \
+		checkFailures++; \
+		fprintf(stderr, "%s:%d: falhou: %s\n", __FILE__, __LINE__, #cond); \
+	} \
+} while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+	unsigned long long a__ = (unsigned long long)(actual); \
+	unsigned long long e__ = (unsigned long long)(expected); \
+	if (a__ != e__) { \
+		checkFailures++; \
+		fprintf(stderr, "%s:%d: falhou: %s == %s (%llu != %llu)\n", \
+				__FILE__, __LINE__, #actual, #expected, a__, e__); \
+	} \
+} while (0)
+
+static int check_result(const char* name)
+{
+	if (checkFailures != 0) {
+		fprintf(stderr, "%s: %d falha(s)\n", name, checkFailures);
+		return 1;
+	}
+	printf("%s: ok\n", name);
+	return 0;
+}
+
+#endif
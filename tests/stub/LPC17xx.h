@@ -0,0 +1,38 @@
+#ifndef LPC17XX_H__
+#define LPC17XX_H__
+
+#include <stdint.h>
+
+/*
+ * Substitui o LPC17xx.h do CMSIS nos testes de host: os registradores
+ * usados pelos modulos testados sao variaveis controladas pelo teste.
+ */
+typedef struct {
+	volatile uint32_t CTRL;
+	volatile uint32_t LOAD;
+	volatile uint32_t VAL;
+	volatile uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct {
+	volatile uint32_t CPUID;
+	volatile uint32_t ICSR;
+	volatile uint32_t SHCSR;
+} SCB_Type;
+
+extern SysTick_Type testSysTick;
+extern SCB_Type testScb;
+extern uint32_t SystemCoreClock;
+extern uint32_t testFaultMask;
+
+#define SysTick (&testSysTick)
+#define SCB (&testScb)
+
+uint32_t SysTick_Config(uint32_t ticks);
+
+static inline void __disable_fault_irq(void)
+{
+	testFaultMask = 1;
+}
+
+#endif
@@ -0,0 +1,13 @@
+#include "LPC17xx.h"
+
+SysTick_Type testSysTick;
+SCB_Type testScb;
+uint32_t SystemCoreClock = 100000000;
+uint32_t testFaultMask = 0;
+
+uint32_t SysTick_Config(uint32_t ticks)
+{
+	testSysTick.LOAD = ticks - 1;
+	testSysTick.VAL = ticks - 1;
+	return 0;
+}
@@ -0,0 +1,228 @@
+#include <stdint.h>
+#include <stdio.h>
+
+#include "check.h"
+
+#include "adaptive_rate.h"
+
+#define MAX_SAMPLES 512
+#define TRACE_MAX 1024
+#define TRACE_FILE "traces/lux_synthetic.csv"
+
+//mesma configuracao de main.c (ISL29003 em 12 bits: minimo de 20 ms)
+static const adaptive_rate_cfg boardCfg = { 20, 1000, 200, 100, 4 };
+
+/*
+ * Sequencia esperada em trechos de mesmo intervalo.
+ */
+typedef struct run {
+	uint32_t intervalMs;
+	uint32_t count;
+} run;
+
+typedef uint32_t (*trace_fn)(uint64_t ms);
+
+static uint32_t intervals[MAX_SAMPLES];
+
+/*
+ * Reproduz um sinal lux(t) amostrando nos instantes pedidos pelo controle,
+ * como o loop de main.c. Retorna o numero de amostras.
+ */
+static uint32_t replay(trace_fn trace, uint64_t durationMs, const adaptive_rate_cfg* cfg)
+{
+	adaptive_rate rate;
+	uint64_t ms = 0;
+	uint32_t count = 0;
+
+	adaptive_rate_init(&rate, cfg, 100);
+	while (ms < durationMs && count < MAX_SAMPLES) {
+		intervals[count] = adaptive_rate_update(&rate, trace(ms), ms);
+		ms += intervals[count];
+		count++;
+	}
+
+	return count;
+}
+
+static void check_runs(const char* name, uint32_t count, const run* runs, uint32_t runCount)
+{
+	uint32_t sample = 0;
+	uint32_t i;
+	uint32_t j;
+
+	for (i = 0; i < runCount; i++) {
+		for (j = 0; j < runs[i].count; j++, sample++) {
+			if (sample >= count || intervals[sample] != runs[i].intervalMs) {
+				checkFailures++;
+				fprintf(stderr, "%s: amostra %u: intervalo %u, esperado %u\n", name,
+						(unsigned)sample, sample < count ? (unsigned)intervals[sample] : 0,
+						(unsigned)runs[i].intervalMs);
+				return;
+			}
+		}
+	}
+	CHECK_EQ(sample, count);
+}
+
+static uint32_t step_trace(uint64_t ms)
+{
+	return (ms < 2000) ? 500 : 1900;
+}
+
+//degrau com +-1 contagem do ADC de 12 bits (~1 lux na faixa de 4000)
+static uint32_t noisy_step_trace(uint64_t ms)
+{
+	return step_trace(ms) - 1 + (uint32_t)((ms / 20) % 3);
+}
+
+static uint32_t quiet_trace(uint64_t ms)
+{
+	return 999 + (uint32_t)((ms / 100) % 3);
+}
+
+//parado em 1000 lux, sobe 300 lux/s entre 2 s e 4 s e para em 1600
+static uint32_t ramp_trace(uint64_t ms)
+{
+	if (ms < 2000) {
+		return 1000;
+	}
+	if (ms < 4000) {
+		return 1000 + (uint32_t)((ms - 2000) * 300 / 1000);
+	}
+	return 1600;
+}
+
+static uint32_t traceMs[TRACE_MAX];
+static uint32_t traceLux[TRACE_MAX];
+static uint32_t traceLen = 0;
+
+static uint32_t synthetic_trace(uint64_t ms)
+{
+	uint32_t i = 0;
+	uint32_t span;
+	uint32_t pos;
+
+	while (i + 1 < traceLen && traceMs[i + 1] <= ms) {
+		i++;
+	}
+	if (i + 1 >= traceLen) {
+		return traceLux[i];
+	}
+
+	//interpolacao linear entre os pontos vizinhos
+	span = traceMs[i + 1] - traceMs[i];
+	pos = (uint32_t)(ms - traceMs[i]);
+	if (traceLux[i + 1] >= traceLux[i]) {
+		return traceLux[i] + (traceLux[i + 1] - traceLux[i]) * pos / span;
+	}
+	return traceLux[i] - (traceLux[i] - traceLux[i + 1]) * pos / span;
+}
+
+static int load_trace(const char* path)
+{
+	FILE* file = fopen(path, "r");
+	char line[64];
+	unsigned ms;
+	unsigned lux;
+
+	if (file == 0) {
+		return 0;
+	}
+	traceLen = 0;
+	while (fgets(line, sizeof(line), file) != 0 && traceLen < TRACE_MAX) {
+		if (sscanf(line, "%u,%u", &ms, &lux) == 2) {
+			traceMs[traceLen] = ms;
+			traceLux[traceLen] = lux;
+			traceLen++;
+		}
+	}
+	fclose(file);
+
+	return traceLen > 0;
+}
+
+/*
+ * Degrau 500 -> 1900 lux: intervalo minimo ja na amostra do degrau, que
+ * continua enquanto a janela tiver amostras dos dois niveis, e depois
+ * dobra a cada quietSamples amostras.
+ */
+static void test_step(void)
+{
+	static const run expected[] = {
+		{ 100, 3 }, { 200, 4 }, { 400, 3 }, //antes do degrau (ate 2300 ms)
+		{ 20, 10 }, { 40, 4 }, { 80, 4 }, { 160, 4 }, { 320, 4 }, { 640, 4 },
+		{ 1000, 3 }
+	};
+
+	check_runs("degrau", replay(step_trace, 10000, &boardCfg),
+			expected, sizeof(expected) / sizeof(expected[0]));
+	// o ruido de quantizacao a 20 ms nao prende o controle no minimo
+	check_runs("degrau com ruido", replay(noisy_step_trace, 10000, &boardCfg),
+			expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+/*
+ * Ruido de +-1 lux nao tira o controle do recuo ate o maximo.
+ */
+static void test_quiet(void)
+{
+	static const run expected[] = {
+		{ 100, 3 }, { 200, 4 }, { 400, 4 }, { 800, 4 }, { 1000, 5 }
+	};
+
+	check_runs("parado", replay(quiet_trace, 10000, &boardCfg),
+			expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+/*
+ * A rampa de 300 lux/s (acima do limiar de 200 lux/s) mantem o intervalo
+ * minimo ate a janela de 20 ms ficar toda em 1600 lux, logo apos o fim da
+ * rampa.
+ */
+static void test_ramp(void)
+{
+	static const run expected[] = {
+		{ 100, 3 }, { 200, 4 }, { 400, 3 },   //parado ate 2300 ms
+		{ 20, 91 },                            //2300 a 4120 ms
+		{ 40, 4 }, { 80, 4 }, { 160, 4 }, { 320, 4 }, { 640, 4 }, { 1000, 3 }
+	};
+
+	check_runs("rampa", replay(ramp_trace, 12000, &boardCfg),
+			expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+/*
+ * Sinal sintetico (tests/traces): lampada acesa em 8 s, sombra entre 15 e
+ * 17 s e nuvem a partir de 22 s.
+ */
+static void test_synthetic(void)
+{
+	static const run expected[] = {
+		{ 100, 3 }, { 200, 4 }, { 400, 4 }, { 800, 4 }, { 1000, 3 },    //0 a 8900 ms
+		{ 20, 10 }, { 40, 4 }, { 80, 4 }, { 160, 4 }, { 320, 4 },       //lampada, vista em 8900 ms
+		{ 640, 4 }, { 1000, 2 },
+		{ 20, 10 }, { 40, 4 }, { 20, 36 }, { 40, 4 }, { 80, 4 },        //sombra, vista em 16060 ms,
+		{ 160, 4 }, { 320, 4 }, { 640, 4 }, { 1000, 1 },                //e a volta da luz
+		{ 20, 10 }, { 40, 4 }, { 80, 4 }, { 160, 2 }, { 20, 8 },        //nuvem, vista em 23100 ms
+		{ 40, 4 }, { 80, 4 }, { 160, 1 }, { 20, 7 }, { 40, 4 }, { 80, 4 },
+		{ 160, 4 }, { 320, 4 }, { 640, 4 }
+	};
+
+	CHECK(load_trace(TRACE_FILE));
+	if (traceLen == 0) {
+		return;
+	}
+
+	check_runs("sintetico", replay(synthetic_trace, traceMs[traceLen - 1] + 100, &boardCfg),
+			expected, sizeof(expected) / sizeof(expected[0]));
+}
+
+int main(void)
+{
+	test_step();
+	test_quiet();
+	test_ramp();
+	test_synthetic();
+
+	return check_result("test_adaptive_rate");
+}
@@ -0,0 +1,702 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "check.h"
+
+#include "boot_layout.h"
+#include "boot_flash.h"
+#include "boot_image.h"
+#include "boot_state.h"
+#include "boot_update.h"
+#include "boot_proto.h"
+
+#define IMAGE_A_SIZE 3000
+#define IMAGE_B_SIZE (5 * BOOT_CHUNK_SIZE + 100)
+
+#define CUT_NONE -1
+#define TORN_WRITE 8 //bytes gravados por uma gravacao interrompida
+
+/*
+ * Flash simulada em RAM: apagar deixa 0xFF, gravar so zera bits (como a
+ * flash real) e so e aceito em paginas apagadas. cutAt simula a queda de
+ * energia na operacao de numero cutAt: ela fica incompleta e todas as
+ * seguintes falham ate power_on().
+ */
+static uint8_t flashMem[BOOT_FLASH_SIZE];
+static uint32_t ops = 0;
+static int32_t cutAt = CUT_NONE;
+static uint32_t powerLost = 0;
+
+static int32_t power_check(void)
+{
+	if (powerLost) {
+		return -1;
+	}
+	if (cutAt != CUT_NONE && ops == (uint32_t)cutAt) {
+		powerLost = 1;
+	}
+	ops++;
+	return 0;
+}
+
+static int32_t ram_erase(void* ctx, uint32_t address, uint32_t len)
+{
+	uint8_t* mem = (uint8_t*)ctx;
+	uint32_t first = boot_flash_sector(address);
+	uint32_t last = boot_flash_sector(address + len - 1);
+	uint32_t base = boot_flash_sectorBase(first);
+	uint32_t end = boot_flash_sectorBase(last + 1);
+
+	CHECK(len != 0 && address + len <= BOOT_FLASH_SIZE);
+	if (power_check() != 0) {
+		return -1;
+	}
+	if (powerLost) {
+		end = base + (end - base) / 2; //apagamento interrompido
+	}
+	memset(&mem[base], 0xFF, end - base);
+
+	return powerLost ? -1 : 0;
+}
+
+static int32_t ram_program(void* ctx, uint32_t address, const uint8_t* data, uint32_t len)
+{
+	uint8_t* mem = (uint8_t*)ctx;
+	uint32_t i;
+
+	CHECK_EQ(address % BOOT_PAGE_SIZE, 0);
+	CHECK_EQ(len % BOOT_PAGE_SIZE, 0);
+	CHECK(address + len <= BOOT_FLASH_SIZE);
+	if (power_check() != 0) {
+		return -1;
+	}
+	for (i = 0; i < len; i++) {
+		CHECK_EQ(mem[address + i], 0xFF);
+	}
+	if (powerLost) {
+		len = TORN_WRITE; //gravacao interrompida
+	}
+	for (i = 0; i < len; i++) {
+		mem[address + i] &= data[i];
+	}
+
+	return powerLost ? -1 : 0;
+}
+
+static const uint8_t* ram_read(void* ctx, uint32_t address)
+{
+	CHECK(address < BOOT_FLASH_SIZE);
+	return &((const uint8_t*)ctx)[address];
+}
+
+static const boot_flash flash = { ram_erase, ram_program, ram_read, flashMem };
+
+static void power_on(void)
+{
+	powerLost = 0;
+	cutAt = CUT_NONE;
+	ops = 0;
+}
+
+/*
+ * CRC-32 bit a bit, independente da tabela de boot_image.c.
+ */
+static uint32_t crc32_ref(const uint8_t* data, uint32_t len)
+{
+	uint32_t crc = 0xFFFFFFFF;
+	uint32_t i;
+	uint32_t bit;
+
+	for (i = 0; i < len; i++) {
+		crc ^= data[i];
+		for (bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320 : 0);
+		}
+	}
+	return ~crc;
+}
+
+static void put_le32(uint8_t* p, uint32_t value)
+{
+	p[0] = (uint8_t)value;
+	p[1] = (uint8_t)(value >> 8);
+	p[2] = (uint8_t)(value >> 16);
+	p[3] = (uint8_t)(value >> 24);
+}
+
+static uint8_t imageA[IMAGE_A_SIZE];
+static uint8_t imageB[IMAGE_B_SIZE];
+
+/*
+ * Imagem ligada para BOOT_APP_BASE: pilha no topo da RAM e reset handler
+ * em Thumb dentro da imagem.
+ */
+static void make_image(uint8_t* image, uint32_t size, uint8_t seed)
+{
+	uint32_t i;
+
+	for (i = 0; i < size; i++) {
+		image[i] = (uint8_t)(i * 7 + seed);
+	}
+	put_le32(&image[0], BOOT_RAM_TOP);
+	put_le32(&image[4], BOOT_APP_BASE + 0x101);
+}
+
+static int app_is(const uint8_t* image, uint32_t size)
+{
+	return memcmp(&flashMem[BOOT_APP_BASE], image, size) == 0;
+}
+
+/*
+ * Ponto de partida: aplicacao A confirmada, sem copia de seguranca.
+ */
+static void baseline(void)
+{
+	boot_record record;
+
+	power_on();
+	memset(flashMem, 0xFF, sizeof(flashMem));
+	memcpy(&flashMem[BOOT_APP_BASE], imageA, IMAGE_A_SIZE);
+
+	memset(&record, 0, sizeof(record));
+	record.state = BOOT_STATE_CONFIRMED;
+	record.appSize = IMAGE_A_SIZE;
+	record.appCrc = crc32_ref(imageA, IMAGE_A_SIZE);
+	CHECK_EQ(boot_state_write(&flash, &record), 0);
+	ops = 0;
+}
+
+/*
+ * Host simulado: monta os quadros e guarda a ultima resposta.
+ */
+static boot_proto proto;
+static boot_record protoRecord;
+static uint8_t response[16];
+static uint32_t responseLen = 0;
+static uint32_t responses = 0;
+static uint8_t seq = 0;
+
+static void capture(void* ctx, const uint8_t* data, uint32_t len)
+{
+	(void)ctx;
+	CHECK(len <= sizeof(response));
+	responseLen = len < sizeof(response) ? len : sizeof(response);
+	memcpy(response, data, responseLen);
+	responses++;
+}
+
+/*
+ * Executa boot_update_select como apos um reset e prepara o protocolo.
+ */
+static uint32_t boot(uint32_t* armWatchdog)
+{
+	uint32_t action;
+
+	power_on();
+	action = boot_update_select(&flash, &protoRecord, armWatchdog);
+	boot_proto_init(&proto, &flash, &protoRecord, capture, 0);
+	return action;
+}
+
+static uint32_t build_frame(uint8_t* out, uint8_t type, uint8_t frameSeq,
+		const uint8_t* payload, uint32_t len)
+{
+	out[0] = BOOT_SOF;
+	out[1] = type;
+	out[2] = frameSeq;
+	out[3] = (uint8_t)len;
+	out[4] = (uint8_t)(len >> 8);
+	if (len != 0) {
+		memcpy(&out[5], payload, len);
+	}
+	put_le32(&out[5 + len], crc32_ref(&out[1], BOOT_FRAME_HEADER + len));
+	return 1 + BOOT_FRAME_HEADER + len + 4;
+}
+
+/*
+ * Status da resposta a type, ou 0xFF se nao houve resposta valida.
+ */
+static uint8_t response_status(uint8_t type, uint8_t frameSeq)
+{
+	if (responseLen != 10 || response[0] != BOOT_SOF || response[1] != (type | BOOT_RESP_FLAG)
+			|| response[2] != frameSeq || response[3] != 1 || response[4] != 0) {
+		return 0xFF;
+	}
+	if (crc32_ref(&response[1], 5) != ((uint32_t)response[6] | ((uint32_t)response[7] << 8)
+			| ((uint32_t)response[8] << 16) | ((uint32_t)response[9] << 24))) {
+		return 0xFF;
+	}
+	return response[5];
+}
+
+static uint8_t command(uint8_t type, const uint8_t* payload, uint32_t len)
+{
+	uint8_t frame[1 + BOOT_FRAME_HEADER + BOOT_PAYLOAD_MAX + 4];
+	uint32_t frameLen;
+	uint32_t before = responses;
+
+	seq++;
+	frameLen = build_frame(frame, type, seq, payload, len);
+	boot_proto_feed(&proto, frame, frameLen);
+	CHECK_EQ(responses, before + 1);
+
+	return response_status(type, seq);
+}
+
+static uint8_t start(uint32_t size, uint32_t crc)
+{
+	uint8_t payload[8];
+
+	put_le32(&payload[0], size);
+	put_le32(&payload[4], crc);
+	return command(BOOT_CMD_START, payload, sizeof(payload));
+}
+
+static uint8_t data(const uint8_t* image, uint32_t size, uint32_t offset)
+{
+	uint8_t payload[BOOT_PAYLOAD_MAX];
+	uint32_t len = size - offset;
+
+	if (len > BOOT_CHUNK_SIZE) {
+		len = BOOT_CHUNK_SIZE;
+	}
+	put_le32(payload, offset);
+	memcpy(&payload[4], &image[offset], len);
+	return command(BOOT_CMD_DATA, payload, 4 + len);
+}
+
+/*
+ * Envia a imagem inteira como boot_send.py; nao envia END.
+ */
+static void transfer(const uint8_t* image, uint32_t size, uint32_t crc)
+{
+	uint32_t offset;
+
+	CHECK_EQ(start(size, crc), BOOT_STATUS_OK);
+	for (offset = 0; offset < size; offset += BOOT_CHUNK_SIZE) {
+		CHECK_EQ(data(image, size, offset), BOOT_STATUS_OK);
+		boot_proto_service(&proto);
+	}
+}
+
+static void confirm(void)
+{
+	boot_record record;
+
+	boot_state_read(&flash, &record);
+	record.state = BOOT_STATE_CONFIRMED;
+	CHECK_EQ(boot_state_write(&flash, &record), 0);
+}
+
+static void test_crc32(void)
+{
+	static const uint8_t check[] = "123456789";
+
+	CHECK_EQ(crc32_ref(check, 9), 0xCBF43926);
+	CHECK_EQ(boot_crc32(0, check, 9), 0xCBF43926);
+	CHECK_EQ(boot_crc32(boot_crc32(0, check, 4), &check[4], 5), 0xCBF43926);
+}
+
+/*
+ * Quadros com CRC invalido sao respondidos com BOOT_STATUS_CRC e nao tem
+ * efeito; lixo antes do SOF e ignorado.
+ */
+static void test_frame_crc(void)
+{
+	uint8_t frame[1 + BOOT_FRAME_HEADER + BOOT_PAYLOAD_MAX + 4];
+	uint8_t payload[8];
+	uint32_t frameLen;
+	uint32_t armWatchdog;
+
+	baseline();
+	boot(&armWatchdog);
+
+	frameLen = build_frame(frame, BOOT_CMD_PING, 1, 0, 0);
+	frame[frameLen - 1] ^= 0x01;
+	boot_proto_feed(&proto, frame, frameLen);
+	CHECK_EQ(response_status(BOOT_CMD_PING, 1), BOOT_STATUS_CRC);
+	CHECK_EQ(proto.frames, 0);
+
+	// START com um bit trocado no payload: nada e apagado
+	put_le32(&payload[0], IMAGE_B_SIZE);
+	put_le32(&payload[4], 0);
+	frameLen = build_frame(frame, BOOT_CMD_START, 2, payload, sizeof(payload));
+	frame[6] ^= 0x80;
+	boot_proto_feed(&proto, frame, frameLen);
+	CHECK_EQ(response_status(BOOT_CMD_START, 2), BOOT_STATUS_CRC);
+	CHECK_EQ(proto.active, 0);
+	CHECK_EQ(ops, 0);
+
+	// o quadro seguinte e aceito, mesmo chegando aos pedacos
+	frameLen = build_frame(frame, BOOT_CMD_PING, 3, 0, 0);
+	boot_proto_feed(&proto, (const uint8_t*)"\x00\x55", 2);
+	boot_proto_feed(&proto, frame, 3);
+	boot_proto_feed(&proto, &frame[3], frameLen - 3);
+	CHECK_EQ(response_status(BOOT_CMD_PING, 3), BOOT_STATUS_OK);
+	CHECK_EQ(proto.frames, 1);
+}
+
+/*
+ * DATA repetido (resposta perdida) e confirmado sem ser gravado de novo;
+ * fora de ordem e recusado com BOOT_STATUS_SEQUENCE.
+ */
+static void test_sequence(void)
+{
+	uint32_t crc = crc32_ref(imageB, IMAGE_B_SIZE);
+	uint32_t armWatchdog;
+	uint32_t offset;
+
+	baseline();
+	boot(&armWatchdog);
+
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 0), BOOT_STATUS_SEQUENCE); //antes do START
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_SEQUENCE);
+
+	CHECK_EQ(start(IMAGE_B_SIZE, crc), BOOT_STATUS_OK);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 0), BOOT_STATUS_OK);
+	CHECK_EQ(boot_proto_service(&proto), 1);
+
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 0), BOOT_STATUS_OK); //reenvio
+	CHECK_EQ(boot_proto_service(&proto), 0);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 2 * BOOT_CHUNK_SIZE), BOOT_STATUS_SEQUENCE);
+
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, BOOT_CHUNK_SIZE), BOOT_STATUS_OK);
+	CHECK_EQ(boot_proto_service(&proto), 1);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 0), BOOT_STATUS_SEQUENCE); //mais antigo que o ultimo
+
+	// END antes do ultimo bloco
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_SEQUENCE);
+
+	for (offset = 2 * BOOT_CHUNK_SIZE; offset < IMAGE_B_SIZE; offset += BOOT_CHUNK_SIZE) {
+		CHECK_EQ(data(imageB, IMAGE_B_SIZE, offset), BOOT_STATUS_OK);
+		boot_proto_service(&proto);
+	}
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_OK);
+	CHECK(app_is(imageB, IMAGE_B_SIZE));
+}
+
+/*
+ * Com os dois buffers aguardando gravacao, o DATA seguinte recebe
+ * BOOT_STATUS_BUSY e e aceito depois que um buffer e gravado.
+ */
+static void test_busy(void)
+{
+	uint32_t armWatchdog;
+
+	baseline();
+	boot(&armWatchdog);
+
+	CHECK_EQ(start(IMAGE_B_SIZE, crc32_ref(imageB, IMAGE_B_SIZE)), BOOT_STATUS_OK);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 0), BOOT_STATUS_OK);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, BOOT_CHUNK_SIZE), BOOT_STATUS_OK);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 2 * BOOT_CHUNK_SIZE), BOOT_STATUS_BUSY);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 2 * BOOT_CHUNK_SIZE), BOOT_STATUS_BUSY);
+
+	CHECK_EQ(boot_proto_service(&proto), 1);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 2 * BOOT_CHUNK_SIZE), BOOT_STATUS_OK);
+	CHECK_EQ(memcmp(&flashMem[BOOT_DOWNLOAD_BASE], imageB, BOOT_CHUNK_SIZE), 0);
+
+	// os blocos pendentes sao gravados em ordem ate o END
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 3 * BOOT_CHUNK_SIZE), BOOT_STATUS_BUSY);
+	CHECK_EQ(boot_proto_service(&proto), 1);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 3 * BOOT_CHUNK_SIZE), BOOT_STATUS_OK);
+	CHECK_EQ(boot_proto_service(&proto), 1);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 4 * BOOT_CHUNK_SIZE), BOOT_STATUS_OK);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 5 * BOOT_CHUNK_SIZE), BOOT_STATUS_BUSY);
+	CHECK_EQ(boot_proto_service(&proto), 1);
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 5 * BOOT_CHUNK_SIZE), BOOT_STATUS_OK);
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_OK);
+	CHECK(app_is(imageB, IMAGE_B_SIZE));
+}
+
+/*
+ * Imagem com CRC diferente do anunciado no START ou com vetores invalidos
+ * e recusada no END sem tocar na aplicacao.
+ */
+static void test_bad_image(void)
+{
+	static uint8_t badVectors[IMAGE_B_SIZE];
+	boot_record record;
+	uint32_t armWatchdog;
+
+	baseline();
+	boot(&armWatchdog);
+
+	transfer(imageB, IMAGE_B_SIZE, crc32_ref(imageB, IMAGE_B_SIZE) ^ 1);
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_IMAGE);
+	CHECK(app_is(imageA, IMAGE_A_SIZE));
+
+	memcpy(badVectors, imageB, IMAGE_B_SIZE);
+	put_le32(&badVectors[0], 0); //pilha fora da RAM
+	transfer(badVectors, IMAGE_B_SIZE, crc32_ref(badVectors, IMAGE_B_SIZE));
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_IMAGE);
+
+	memcpy(badVectors, imageB, IMAGE_B_SIZE);
+	put_le32(&badVectors[4], BOOT_APP_BASE + 0x100); //reset handler em ARM
+	transfer(badVectors, IMAGE_B_SIZE, crc32_ref(badVectors, IMAGE_B_SIZE));
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_IMAGE);
+
+	CHECK(app_is(imageA, IMAGE_A_SIZE));
+	ops = 0;
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_IMAGE); //repetido: mesmo status
+	CHECK_EQ(ops, 0);
+	boot_state_read(&flash, &record);
+	CHECK_EQ(record.state, BOOT_STATE_CONFIRMED);
+	CHECK_EQ(record.backupSize, 0);
+	CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_RUN_APP);
+	CHECK_EQ(armWatchdog, 0);
+}
+
+/*
+ * Resposta do END perdida: o END reenviado recebe o resultado da instalacao
+ * ja feita, sem instalar de novo, e o host segue para o RUN.
+ */
+static void test_end_repeated(void)
+{
+	boot_record before;
+	boot_record after;
+	uint32_t armWatchdog;
+
+	baseline();
+	boot(&armWatchdog);
+	transfer(imageB, IMAGE_B_SIZE, crc32_ref(imageB, IMAGE_B_SIZE));
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_OK);
+	boot_state_read(&flash, &before);
+
+	ops = 0;
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_OK);
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_OK);
+	CHECK_EQ(ops, 0);
+	boot_state_read(&flash, &after);
+	CHECK_EQ(after.sequence, before.sequence);
+	CHECK_EQ(after.state, BOOT_STATE_TRIAL);
+	CHECK(app_is(imageB, IMAGE_B_SIZE));
+
+	CHECK_EQ(data(imageB, IMAGE_B_SIZE, 0), BOOT_STATUS_SEQUENCE);
+	CHECK_EQ(command(BOOT_CMD_RUN, 0, 0), BOOT_STATUS_OK);
+
+	// um START novo descarta o resultado anterior
+	CHECK_EQ(start(IMAGE_B_SIZE, crc32_ref(imageB, IMAGE_B_SIZE)), BOOT_STATUS_OK);
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_SEQUENCE);
+}
+
+/*
+ * Primeira atualizacao de uma aplicacao gravada pelo debugger (sem
+ * registro): o slot inteiro vira a copia de seguranca.
+ */
+static void test_install_from_debugger(void)
+{
+	boot_record record;
+	uint32_t armWatchdog;
+
+	power_on();
+	memset(flashMem, 0xFF, sizeof(flashMem));
+	memcpy(&flashMem[BOOT_APP_BASE], imageA, IMAGE_A_SIZE);
+
+	CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_RUN_APP);
+	CHECK_EQ(protoRecord.state, BOOT_STATE_EMPTY);
+	transfer(imageB, IMAGE_B_SIZE, crc32_ref(imageB, IMAGE_B_SIZE));
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_OK);
+	CHECK(app_is(imageB, IMAGE_B_SIZE));
+	CHECK_EQ(memcmp(&flashMem[BOOT_BACKUP_BASE], imageA, IMAGE_A_SIZE), 0);
+
+	boot_state_read(&flash, &record);
+	CHECK_EQ(record.state, BOOT_STATE_TRIAL);
+	CHECK_EQ(record.backupSize, BOOT_SLOT_SIZE);
+	CHECK_EQ(record.appSize, IMAGE_B_SIZE);
+
+	CHECK_EQ(command(BOOT_CMD_RUN, 0, 0), BOOT_STATUS_OK);
+	CHECK_EQ(proto.runRequested, 1);
+}
+
+/*
+ * Queda de energia em cada operacao de flash da instalacao: depois do
+ * reset a aplicacao A continua (ou volta a ser) a executada.
+ */
+static void test_power_loss_install(void)
+{
+	boot_record record;
+	uint32_t armWatchdog;
+	uint32_t total;
+	uint32_t cut;
+
+	baseline();
+	boot(&armWatchdog);
+	transfer(imageB, IMAGE_B_SIZE, crc32_ref(imageB, IMAGE_B_SIZE));
+	ops = 0;
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_OK);
+	total = ops;
+	CHECK(total > IMAGE_A_SIZE / BOOT_PAGE_SIZE + IMAGE_B_SIZE / BOOT_PAGE_SIZE);
+
+	for (cut = 0; cut < total; cut++) {
+		baseline();
+		boot(&armWatchdog);
+		transfer(imageB, IMAGE_B_SIZE, crc32_ref(imageB, IMAGE_B_SIZE));
+		ops = 0;
+		cutAt = (int32_t)cut;
+		CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_FLASH);
+		CHECK_EQ(powerLost, 1);
+
+		CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_RUN_APP);
+		CHECK_EQ(armWatchdog, 0);
+		if (!app_is(imageA, IMAGE_A_SIZE)) {
+			checkFailures++;
+			fprintf(stderr, "queda na operacao %u: aplicacao A perdida\n", (unsigned)cut);
+		}
+		boot_state_read(&flash, &record);
+		CHECK(record.state == BOOT_STATE_CONFIRMED || record.state == BOOT_STATE_ROLLED_BACK);
+		CHECK_EQ(record.appCrc, crc32_ref(imageA, IMAGE_A_SIZE));
+	}
+}
+
+/*
+ * Imagem em teste que nunca confirma: BOOT_TRIAL_ATTEMPTS partidas com o
+ * watchdog e depois a copia anterior e restaurada.
+ */
+static void test_trial_rollback(void)
+{
+	boot_record record;
+	uint32_t armWatchdog;
+	uint32_t attempt;
+
+	baseline();
+	boot(&armWatchdog);
+	transfer(imageB, IMAGE_B_SIZE, crc32_ref(imageB, IMAGE_B_SIZE));
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_OK);
+
+	for (attempt = 1; attempt <= BOOT_TRIAL_ATTEMPTS; attempt++) {
+		CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_RUN_APP);
+		CHECK_EQ(armWatchdog, 1);
+		CHECK_EQ(protoRecord.state, BOOT_STATE_TRIAL);
+		CHECK_EQ(protoRecord.attempts, attempt);
+		CHECK(app_is(imageB, IMAGE_B_SIZE));
+	}
+
+	CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_RUN_APP);
+	CHECK_EQ(armWatchdog, 0);
+	CHECK_EQ(protoRecord.state, BOOT_STATE_ROLLED_BACK);
+	CHECK(app_is(imageA, IMAGE_A_SIZE));
+
+	// a imagem com falha nao volta a ser testada
+	CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_RUN_APP);
+	CHECK_EQ(armWatchdog, 0);
+	boot_state_read(&flash, &record);
+	CHECK_EQ(record.state, BOOT_STATE_ROLLED_BACK);
+	CHECK_EQ(record.appSize, IMAGE_A_SIZE);
+
+	// confirmada na segunda partida: segue sem watchdog
+	baseline();
+	boot(&armWatchdog);
+	transfer(imageB, IMAGE_B_SIZE, crc32_ref(imageB, IMAGE_B_SIZE));
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_OK);
+	CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_RUN_APP);
+	CHECK_EQ(armWatchdog, 1);
+	confirm();
+	CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_RUN_APP);
+	CHECK_EQ(armWatchdog, 0);
+	CHECK(app_is(imageB, IMAGE_B_SIZE));
+}
+
+/*
+ * Os registros enchem um setor e passam para o outro; a queda durante a
+ * troca de setor nao perde o registro atual.
+ */
+static void test_state_sectors(void)
+{
+	boot_record record;
+	uint32_t pages = BOOT_STATE_SECTOR / BOOT_PAGE_SIZE;
+	uint32_t i;
+
+	power_on();
+	memset(flashMem, 0xFF, sizeof(flashMem));
+	CHECK_EQ(boot_state_read(&flash, &record), 1);
+	CHECK_EQ(record.state, BOOT_STATE_EMPTY);
+
+	for (i = 1; i <= 2 * pages; i++) {
+		memset(&record, 0, sizeof(record));
+		record.attempts = i; //marca do registro
+		CHECK_EQ(boot_state_write(&flash, &record), 0);
+		CHECK_EQ(boot_state_read(&flash, &record), 0);
+		CHECK_EQ(record.attempts, i);
+		CHECK_EQ(record.sequence, i);
+	}
+	// os dois setores cheios, sem nenhum apagamento
+	CHECK_EQ(flashMem[BOOT_STATE_BASE + BOOT_STATE_SECTOR - BOOT_PAGE_SIZE], 0x47);
+	CHECK_EQ(flashMem[BOOT_STATE_BASE + 2 * BOOT_STATE_SECTOR - BOOT_PAGE_SIZE], 0x47);
+
+	// queda no apagamento do setor antigo e depois na gravacao
+	for (i = 0; i < 2; i++) {
+		ops = 0;
+		cutAt = (int32_t)i;
+		memset(&record, 0, sizeof(record));
+		record.attempts = 1000;
+		CHECK(boot_state_write(&flash, &record) != 0);
+		power_on();
+		CHECK_EQ(boot_state_read(&flash, &record), 0);
+		CHECK_EQ(record.attempts, 2 * pages);
+	}
+
+	memset(&record, 0, sizeof(record));
+	record.attempts = 1000;
+	CHECK_EQ(boot_state_write(&flash, &record), 0);
+	CHECK_EQ(boot_state_read(&flash, &record), 0);
+	CHECK_EQ(record.attempts, 1000);
+	CHECK_EQ(record.sequence, 2 * pages + 1);
+	CHECK_EQ(memcmp(&flashMem[BOOT_STATE_BASE], &record, sizeof(record)), 0);
+}
+
+/*
+ * Pedido de atualizacao da aplicacao: o bootloader fica aguardando uma
+ * unica vez, mesmo com a aplicacao valida.
+ */
+static void test_update_request(void)
+{
+	boot_record record;
+	uint32_t armWatchdog;
+
+	baseline();
+	boot_state_read(&flash, &record);
+	record.updateRequested = 1;
+	CHECK_EQ(boot_state_write(&flash, &record), 0);
+
+	CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_STAY);
+	CHECK_EQ(armWatchdog, 0);
+	boot_state_read(&flash, &record);
+	CHECK_EQ(record.updateRequested, 0);
+	CHECK_EQ(record.state, BOOT_STATE_CONFIRMED);
+
+	// a atualizacao segue normalmente a partir daqui
+	transfer(imageB, IMAGE_B_SIZE, crc32_ref(imageB, IMAGE_B_SIZE));
+	CHECK_EQ(command(BOOT_CMD_END, 0, 0), BOOT_STATUS_OK);
+	CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_RUN_APP);
+	CHECK_EQ(armWatchdog, 1);
+
+	// sem atualizacao, o reset seguinte executa a aplicacao
+	baseline();
+	boot_state_read(&flash, &record);
+	record.updateRequested = 1;
+	CHECK_EQ(boot_state_write(&flash, &record), 0);
+	CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_STAY);
+	CHECK_EQ(boot(&armWatchdog), BOOT_ACTION_RUN_APP);
+	CHECK(app_is(imageA, IMAGE_A_SIZE));
+}
+
+int main(void)
+{
+	make_image(imageA, IMAGE_A_SIZE, 0x11);
+	make_image(imageB, IMAGE_B_SIZE, 0x5A);
+
+	test_crc32();
+	test_frame_crc();
+	test_sequence();
+	test_busy();
+	test_bad_image();
+	test_end_repeated();
+	test_install_from_debugger();
+	test_power_loss_install();
+	test_trial_rollback();
+	test_state_sectors();
+	test_update_request();
+
+	return check_result("test_boot");
+}
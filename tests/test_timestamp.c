@@ -0,0 +1,194 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "check.h"
+
+/*
+ * O modulo e incluido diretamente para que o teste controle os pontos de
+ * preempcao e o estado interno do contador.
+ */
+static void preempt(void);
+#define TIMESTAMP_PREEMPT_POINT() preempt()
+#include "../src/timestamp.c"
+
+#define RELOAD (100000 - 1) //SysTick de 1 ms a 100 MHz
+#define TICKS_PER_US 100
+
+//cenarios de preempcao
+#define PREEMPT_NONE 0
+#define PREEMPT_WRITER 1 //um leitor interrompe timestamp_tick
+#define PREEMPT_READER 2 //o SysTick interrompe a leitura
+
+static int scenario = PREEMPT_NONE;
+static int nested = 0;
+static int step = 0;
+static int target = 0;
+static uint64_t expected = 0;
+static int reads = 0;
+
+static void preempt(void)
+{
+	uint32_t inactive;
+
+	if (nested) {
+		return;
+	}
+	nested = 1;
+	step++;
+
+	if (scenario == PREEMPT_WRITER) {
+		// antes de cada escrita de copia (passos 3 e 5), a copia sendo
+		// escrita pode estar pela metade: corrompe para provar que nao e lida
+		if (step == 3 || step == 5) {
+			inactive = (generation & 1) ^ 1;
+			msCount[inactive] = 0xDEADBEEF00000000ULL;
+		}
+
+		CHECK_EQ(timestamp_ms(), expected);
+		CHECK_EQ(timestamp_now(), expected * 1000);
+		reads++;
+	} else if (scenario == PREEMPT_READER && step == target) {
+		timestamp_tick();
+	}
+
+	nested = 0;
+}
+
+static void set_ms(uint64_t ms)
+{
+	generation = 0;
+	msCount[0] = ms;
+	msCount[1] = ms;
+}
+
+static void test_compose(void)
+{
+	// SysTick acabou de recarregar: inicio do milissegundo
+	CHECK_EQ(timestamp_compose(5, RELOAD, RELOAD, 0, TICKS_PER_US), 5000);
+	// ultimo ciclo antes da recarga
+	CHECK_EQ(timestamp_compose(5, RELOAD, 0, 0, TICKS_PER_US), 5999);
+	// meio do milissegundo
+	CHECK_EQ(timestamp_compose(5, RELOAD, RELOAD - 50000, 0, TICKS_PER_US), 5500);
+	// recarga pendente: o contador ja pertence ao milissegundo seguinte
+	CHECK_EQ(timestamp_compose(5, RELOAD, RELOAD, 1, TICKS_PER_US), 6000);
+	CHECK_EQ(timestamp_compose(5, RELOAD, RELOAD - 100, 1, TICKS_PER_US), 6001);
+	// valores fora da faixa sao limitados
+	CHECK_EQ(timestamp_compose(5, RELOAD, RELOAD + 10, 0, TICKS_PER_US), 5000);
+	CHECK_EQ(timestamp_compose(5, RELOAD, 0, 0, 0), 5999);
+	// carry para a parte alta
+	CHECK_EQ(timestamp_compose(0xFFFFFFFFULL, RELOAD, RELOAD, 1, TICKS_PER_US),
+			0x100000000ULL * 1000);
+}
+
+static void test_to_string(void)
+{
+	uint8_t text[21];
+
+	CHECK_EQ(timestamp_toString(UINT64_MAX, text, sizeof(text)), 20);
+	CHECK(strcmp((const char*)text, "18446744073709551615") == 0);
+
+	CHECK_EQ(timestamp_toString(UINT64_MAX, text, 20), 0);
+	CHECK_EQ(text[0], '\0');
+
+	CHECK_EQ(timestamp_toString(0, text, 2), 1);
+	CHECK(strcmp((const char*)text, "0") == 0);
+	CHECK_EQ(timestamp_toString(0, text, 1), 0);
+}
+
+static void test_carry(void)
+{
+	uint64_t ms;
+	uint64_t last;
+
+	set_ms(0xFFFFFFF0ULL);
+	last = timestamp_ms();
+	for (ms = 0; ms < 32; ms++) {
+		timestamp_tick();
+		CHECK_EQ(timestamp_ms(), last + 1);
+		last = timestamp_ms();
+	}
+	CHECK_EQ(last, 0x100000010ULL);
+}
+
+/*
+ * Leitores (timestamp_ms e timestamp_now) executados em cada ponto de
+ * timestamp_tick, inclusive antes da primeira escrita, como uma ISR de
+ * prioridade maior que a do SysTick. O SysTick ja recarregou e a entrada
+ * na excecao ja limpou PENDSTSET, entao o valor esperado e sempre o novo.
+ */
+static void test_reader_preempts_writer(uint64_t start)
+{
+	set_ms(start);
+	testSysTick.VAL = RELOAD;
+	testScb.ICSR = 0;
+	testScb.SHCSR = SHCSR_SYSTICKACT;
+	testFaultMask = 0;
+
+	scenario = PREEMPT_WRITER;
+	step = 0;
+	reads = 0;
+	expected = start + 1;
+	timestamp_tick();
+	scenario = PREEMPT_NONE;
+
+	CHECK_EQ(reads, 6);
+	// o fim do handler roda com FAULTMASK: nenhum leitor ve tickApplied em 0
+	CHECK_EQ(testFaultMask, 1);
+	CHECK_EQ(tickApplied, 0);
+
+	// retorno da excecao: SysTick inativo, o valor nao muda
+	testScb.SHCSR = 0;
+	CHECK_EQ(timestamp_ms(), start + 1);
+	CHECK_EQ(timestamp_now(), (start + 1) * 1000);
+}
+
+/*
+ * Um tick completo injetado em cada ponto da leitura: a leitura e refeita
+ * e retorna o valor novo.
+ */
+static void test_writer_preempts_reader(uint64_t start)
+{
+	for (target = 1; target <= 2; target++) {
+		set_ms(start);
+		scenario = PREEMPT_READER;
+		step = 0;
+		CHECK_EQ(timestamp_ms(), start + 1);
+		scenario = PREEMPT_NONE;
+	}
+
+	for (target = 1; target <= 2; target++) {
+		set_ms(start);
+		testSysTick.VAL = RELOAD;
+		testScb.ICSR = 0;
+		scenario = PREEMPT_READER;
+		step = 0;
+		CHECK_EQ(timestamp_now(), (start + 1) * 1000);
+		scenario = PREEMPT_NONE;
+	}
+}
+
+static void test_now_pending(void)
+{
+	set_ms(0xFFFFFFFFULL);
+	testSysTick.VAL = RELOAD - 200;
+	testScb.ICSR = ICSR_PENDSTSET;
+	CHECK_EQ(timestamp_now(), 0x100000000ULL * 1000 + 2);
+	testScb.ICSR = 0;
+}
+
+int main(void)
+{
+	CHECK_EQ(timestamp_init(), 0);
+	CHECK_EQ(testSysTick.LOAD, RELOAD);
+
+	test_compose();
+	test_to_string();
+	test_carry();
+	test_reader_preempts_writer(5);
+	test_reader_preempts_writer(0xFFFFFFFFULL);
+	test_writer_preempts_reader(5);
+	test_writer_preempts_reader(0xFFFFFFFFULL);
+	test_now_pending();
+
+	return check_result("test_timestamp");
+}
@@ -0,0 +1,396 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "check.h"
+
+#include "uart_session.h"
+#include "sensor_state.h"
+#include "timestamp.h"
+
+#define LINK_BUFFER_SIZE 8192
+
+/*
+ * Link serial simulado: o teste escreve em rx o que o host enviaria e le
+ * em tx o que a sessao transmitiu. sendLimit limita os bytes aceitos por
+ * chamada, como a FIFO da UART.
+ */
+typedef struct fake_link {
+	uint8_t rx[256];
+	uint32_t rxLen;
+	uint32_t rxPos;
+	uint8_t tx[LINK_BUFFER_SIZE];
+	uint32_t txLen;
+	uint32_t sendLimit;
+} fake_link;
+
+static uint32_t fake_receive(void* ctx, uint8_t* data, uint32_t len)
+{
+	fake_link* link = (fake_link*)ctx;
+	uint32_t count = 0;
+
+	while (count < len && link->rxPos < link->rxLen) {
+		data[count++] = link->rx[link->rxPos++];
+	}
+	return count;
+}
+
+static uint32_t fake_send(void* ctx, const uint8_t* data, uint32_t len)
+{
+	fake_link* link = (fake_link*)ctx;
+
+	if (len > link->sendLimit) {
+		len = link->sendLimit;
+	}
+	if (len > LINK_BUFFER_SIZE - link->txLen) {
+		len = LINK_BUFFER_SIZE - link->txLen;
+	}
+	memcpy(&link->tx[link->txLen], data, len);
+	link->txLen += len;
+	return len;
+}
+
+static fake_link linkA;
+static fake_link linkB;
+static const uart_port portA = { fake_receive, fake_send, &linkA };
+static const uart_port portB = { fake_receive, fake_send, &linkB };
+static uart_session sessionA;
+static uart_session sessionB;
+
+static uint8_t lastRange = 0;
+static uint32_t rangeCalls = 0;
+
+static void fake_set_range(uint8_t range)
+{
+	lastRange = range;
+	rangeCalls++;
+	sensor_state_setRange(range);
+}
+
+static void link_reset(fake_link* link, uint32_t sendLimit)
+{
+	memset(link, 0, sizeof(*link));
+	link->sendLimit = sendLimit;
+}
+
+static void link_input(fake_link* link, const char* str)
+{
+	uint32_t len = strlen(str);
+
+	memcpy(&link->rx[link->rxLen], str, len);
+	link->rxLen += len;
+}
+
+static void link_clear_tx(fake_link* link)
+{
+	link->txLen = 0;
+}
+
+static const uint8_t* find(const fake_link* link, const void* needle, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i + len <= link->txLen; i++) {
+		if (memcmp(&link->tx[i], needle, len) == 0) {
+			return &link->tx[i];
+		}
+	}
+	return 0;
+}
+
+static int contains(const fake_link* link, const char* str)
+{
+	return find(link, str, strlen(str)) != 0;
+}
+
+/*
+ * Monta o quadro binario esperado, com o timestamp de envio no cabecalho.
+ * Retorna o tamanho do quadro.
+ */
+static uint32_t build_frame(uint8_t* frame, uint8_t type, const uint8_t* payload,
+		uint8_t len, timestamp_t sentAt)
+{
+	uint8_t checksum = 0;
+	uint32_t i;
+
+	frame[0] = UART_SESSION_FRAME_SOF;
+	frame[1] = type;
+	frame[2] = len;
+	for (i = 0; i < 8; i++) {
+		frame[3 + i] = (uint8_t)(sentAt >> (8 * i));
+	}
+	memcpy(&frame[UART_SESSION_FRAME_HEADER], payload, len);
+	for (i = 1; i < UART_SESSION_FRAME_HEADER + (uint32_t)len; i++) {
+		checksum ^= frame[i];
+	}
+	frame[UART_SESSION_FRAME_HEADER + len] = checksum;
+	return UART_SESSION_FRAME_HEADER + 1u + len;
+}
+
+/*
+ * Procura um quadro com um byte de payload enviado em sentAt.
+ */
+static const uint8_t* find_frame(const fake_link* link, uint8_t type, uint8_t value,
+		timestamp_t sentAt)
+{
+	uint8_t expected[UART_SESSION_FRAME_HEADER + 2];
+
+	return find(link, expected, build_frame(expected, type, &value, 1, sentAt));
+}
+
+static void advance_ms(uint32_t ms)
+{
+	while (ms-- > 0) {
+		timestamp_tick();
+	}
+}
+
+static void poll_both(void)
+{
+	uart_session_poll(&sessionA);
+	uart_session_poll(&sessionB);
+}
+
+static void setup(uint32_t sendLimit)
+{
+	link_reset(&linkA, sendLimit);
+	link_reset(&linkB, sendLimit);
+	uart_session_init(&sessionA, &portA, fake_set_range);
+	uart_session_init(&sessionB, &portB, fake_set_range);
+	sensor_state_setRange(RANGE_4000);
+	rangeCalls = 0;
+	// menu inicial
+	do {
+		poll_both();
+	} while (sessionA.txHead != sessionA.txTail || sessionB.txHead != sessionB.txTail);
+	link_clear_tx(&linkA);
+	link_clear_tx(&linkB);
+}
+
+/*
+ * Linhas chegam aos pedacos e intercaladas entre as portas; cada sessao
+ * monta a sua linha e so executa o comando no fim dela.
+ */
+static void test_partial_lines(void)
+{
+	setup(UINT32_MAX);
+
+	link_input(&linkA, "3");
+	link_input(&linkB, "x");
+	poll_both();
+	CHECK_EQ(rangeCalls, 0);
+	CHECK_EQ(linkA.txLen, 0);
+	CHECK_EQ(linkB.txLen, 0);
+
+	link_input(&linkB, "y\r");
+	poll_both();
+	CHECK_EQ(rangeCalls, 0);
+	CHECK(contains(&linkB, "Opcao invalida"));
+	CHECK(!contains(&linkA, "Opcao invalida"));
+
+	link_input(&linkA, "\r\n");
+	poll_both();
+	CHECK_EQ(rangeCalls, 1);
+	CHECK_EQ(lastRange, RANGE_4000);
+	CHECK(contains(&linkA, "faixa de 0 a 4000."));
+	CHECK(!contains(&linkB, "faixa de 0 a 4000."));
+
+	// linha maior que UART_SESSION_LINE_MAX e descartada inteira
+	link_clear_tx(&linkA);
+	link_input(&linkA, "22222222222222222222");
+	poll_both();
+	link_input(&linkA, "\r");
+	poll_both();
+	CHECK_EQ(rangeCalls, 1);
+	CHECK(contains(&linkA, "Opcao invalida"));
+}
+
+/*
+ * Modo binario em uma porta nao altera a saida da outra.
+ */
+static void test_mode_per_session(void)
+{
+	static const uint8_t sampleHeader[] = { 0x7E, 0x01, 0x0D };
+	const uint8_t* frame;
+	timestamp_t sentAt;
+	uint8_t checksum;
+	uint32_t i;
+
+	setup(UINT32_MAX);
+	sensor_state_publish(1234, 5678);
+
+	advance_ms(3);
+	link_input(&linkA, "b\r");
+	poll_both();
+	CHECK(find_frame(&linkA, UART_SESSION_FRAME_MODE, UART_SESSION_BINARY,
+			timestamp_now()) != 0);
+	CHECK_EQ(linkB.txLen, 0);
+
+	link_clear_tx(&linkA);
+	advance_ms(2);
+	sentAt = timestamp_now();
+	link_input(&linkA, "1\r");
+	link_input(&linkB, "1\r");
+	poll_both();
+
+	CHECK(contains(&linkB, "Valor lido pelo sensor: 1234 lux @ 5678 us"));
+	CHECK(!contains(&linkA, "Valor lido"));
+
+	frame = find(&linkA, sampleHeader, sizeof(sampleHeader));
+	CHECK(frame != 0);
+	if (frame != 0) {
+		for (i = 0; i < 8; i++) { //envio, little endian
+			CHECK_EQ(frame[3 + i], (uint8_t)(sentAt >> (8 * i)));
+		}
+		CHECK_EQ(frame[11], 5678 & 0xFF); //aquisicao
+		CHECK_EQ(frame[12], 5678 >> 8);
+		CHECK_EQ(frame[19], 1234 & 0xFF); //lux
+		CHECK_EQ(frame[20], 1234 >> 8);
+		CHECK_EQ(frame[23], RANGE_4000);
+		checksum = 0;
+		for (i = 1; i < 24; i++) {
+			checksum ^= frame[i];
+		}
+		CHECK_EQ(frame[24], checksum);
+	}
+
+	// de volta ao texto so na porta A
+	link_clear_tx(&linkA);
+	link_input(&linkA, "t\r");
+	poll_both();
+	CHECK(contains(&linkA, "Saida em texto."));
+	CHECK_EQ(sessionA.mode, UART_SESSION_TEXT);
+	CHECK_EQ(sessionB.mode, UART_SESSION_TEXT);
+}
+
+/*
+ * Com a UART aceitando poucos bytes por chamada, a fila enche; mensagens
+ * que nao cabem sao descartadas inteiras e as aceitas saem completas.
+ */
+static void test_queue_full(void)
+{
+	static const char message[] = "mensagem de 32 bytes na fila..\r\n";
+	uint32_t accepted = 0;
+	uint32_t i;
+
+	setup(4);
+	CHECK_EQ(sessionA.txHead, sessionA.txTail);
+
+	while (uart_session_print(&sessionA, message)) {
+		accepted++;
+	}
+	CHECK_EQ(accepted, (UART_SESSION_TXQ_SIZE - 1) / (sizeof(message) - 1));
+	CHECK_EQ(sessionA.txDropped, 1);
+
+	// nada e enfileirado pela metade
+	CHECK_EQ(uart_session_print(&sessionA, message), 0);
+	CHECK_EQ(sessionA.txDropped, 2);
+
+	uart_session_poll(&sessionA);
+	CHECK_EQ(linkA.txLen, 4);
+
+	for (i = 0; i < UART_SESSION_TXQ_SIZE; i++) {
+		uart_session_poll(&sessionA);
+	}
+	CHECK_EQ(linkA.txLen, accepted * (sizeof(message) - 1));
+	for (i = 0; i < accepted; i++) {
+		CHECK(memcmp(&linkA.tx[i * (sizeof(message) - 1)], message, sizeof(message) - 1) == 0);
+	}
+	CHECK_EQ(linkB.txLen, 0);
+}
+
+/*
+ * A faixa configurada por uma porta aparece no estado lido pela outra.
+ */
+static void test_shared_range(void)
+{
+	sensor_sample sample;
+
+	setup(UINT32_MAX);
+
+	link_input(&linkA, "5\r");
+	poll_both();
+	CHECK_EQ(lastRange, RANGE_64000);
+
+	sensor_state_snapshot(&sample);
+	CHECK_EQ(sample.range, RANGE_64000);
+
+	// a porta B mostra a nova faixa ao reexibir o menu
+	link_input(&linkB, "1\r");
+	poll_both();
+	poll_both();
+	CHECK(contains(&linkB, "Faixa atual do sensor configurada = 0 a 64000"));
+
+	link_clear_tx(&linkB);
+	link_input(&linkB, "b\r1\r");
+	poll_both();
+	CHECK(linkB.txLen > 0 && linkB.tx[linkB.txLen - 2] == RANGE_64000);
+}
+
+/*
+ * 'u' marca o pedido de atualizacao so na sessao que o recebeu; a resposta
+ * sai antes de main reiniciar a placa.
+ */
+static void test_update_request(void)
+{
+	setup(UINT32_MAX);
+
+	link_input(&linkA, "u\r");
+	poll_both();
+	CHECK_EQ(sessionA.updateRequested, 1);
+	CHECK_EQ(sessionB.updateRequested, 0);
+	CHECK(contains(&linkA, "Reiniciando no bootloader"));
+	CHECK(uart_session_txIdle(&sessionA));
+
+	setup(4);
+	link_input(&linkB, "b\ru\r");
+	poll_both();
+	CHECK_EQ(sessionB.updateRequested, 1);
+	CHECK(!uart_session_txIdle(&sessionB));
+	while (!uart_session_txIdle(&sessionB)) {
+		uart_session_poll(&sessionB);
+	}
+	CHECK(find_frame(&linkB, UART_SESSION_FRAME_UPDATE, 1, timestamp_now()) != 0);
+	CHECK_EQ(sessionA.updateRequested, 0);
+}
+
+/*
+ * Todo quadro binario leva no cabecalho o timestamp do envio, nao so as
+ * amostras.
+ */
+static void test_frame_timestamps(void)
+{
+	timestamp_t rangeAt;
+	timestamp_t errorAt;
+
+	setup(UINT32_MAX);
+	link_input(&linkA, "b\r");
+	poll_both();
+	link_clear_tx(&linkA);
+
+	advance_ms(7);
+	rangeAt = timestamp_now();
+	link_input(&linkA, "4\r");
+	poll_both();
+
+	advance_ms(11);
+	errorAt = timestamp_now();
+	link_input(&linkA, "x\r");
+	poll_both();
+
+	CHECK(rangeAt != errorAt);
+	CHECK(find_frame(&linkA, UART_SESSION_FRAME_RANGE, RANGE_16000, rangeAt) != 0);
+	CHECK(find_frame(&linkA, UART_SESSION_FRAME_ERROR, 0, errorAt) != 0);
+	CHECK(find_frame(&linkA, UART_SESSION_FRAME_ERROR, 0, rangeAt) == 0);
+}
+
+int main(void)
+{
+	test_partial_lines();
+	test_mode_per_session();
+	test_queue_full();
+	test_shared_range();
+	test_update_request();
+	test_frame_timestamps();
+
+	return check_result("test_uart_session");
+}
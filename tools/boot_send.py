@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+"""
+Envia uma imagem (.bin gerado no post-build, ex.: Release/uart2.bin) para o
+bootloader serial pela UART3. Protocolo descrito em
+bootloader/src/boot_proto.h.
+
+Uso:
+    boot_send.py /dev/ttyUSB0 Release/uart2.bin [--baud 230400]
+
+Primeiro envia o comando 'u' ao menu da aplicacao (115200 bps): a
+aplicacao registra o pedido e reinicia no bootloader, que fica aguardando
+a imagem. Com --no-request (aplicacao travada ou ausente), reinicie a placa
+durante a execucao: sem pedido o bootloader so aguarda o primeiro quadro
+por 500 ms apos o reset. Requer pyserial.
+"""
+
+import argparse
+import struct
+import sys
+import time
+import zlib
+
+SOF = 0x7E
+RESP_FLAG = 0x80
+
+CMD_PING = 0x00
+CMD_START = 0x01
+CMD_DATA = 0x02
+CMD_END = 0x03
+CMD_RUN = 0x04
+
+STATUS_OK = 0
+STATUS_CRC = 1
+STATUS_BUSY = 3
+STATUS_NAMES = ["OK", "CRC", "SEQUENCE", "BUSY", "FLASH", "IMAGE", "LENGTH", "COMMAND"]
+
+APP_BAUD = 115200
+APP_UPDATE_COMMAND = b"\ru\r" #descarta linha incompleta e envia 'u'
+APP_RESET_DELAY = 0.5
+
+CHUNK_SIZE = 512
+SLOT_SIZE = 0x20000
+RETRIES = 5
+
+
+class BootError(Exception):
+    pass
+
+
+def frame(command, seq, payload=b""):
+    body = struct.pack("<BBH", command, seq, len(payload)) + payload
+    return bytes([SOF]) + body + struct.pack("<I", zlib.crc32(body) & 0xFFFFFFFF)
+
+
+class Link(object):
+    def __init__(self, port):
+        self.port = port
+        self.seq = 0
+
+    def read_response(self, timeout):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            byte = self.port.read(1)
+            if not byte or byte[0] != SOF:
+                continue
+            rest = self.port.read(9)
+            if len(rest) != 9:
+                continue
+            if struct.unpack("<I", rest[5:9])[0] != zlib.crc32(rest[0:5]) & 0xFFFFFFFF:
+                continue
+            return rest[0], rest[1], rest[4]
+        return None
+
+    def command(self, command, payload=b"", timeout=1.0):
+        """Envia um comando e aguarda a resposta com o mesmo seq."""
+        for _ in range(RETRIES):
+            self.seq = (self.seq + 1) & 0xFF
+            self.port.write(frame(command, self.seq, payload))
+            deadline = time.time() + timeout
+            while time.time() < deadline:
+                response = self.read_response(deadline - time.time())
+                if response is None:
+                    break
+                kind, seq, status = response
+                if kind != command | RESP_FLAG or seq != self.seq:
+                    continue  # resposta atrasada de uma tentativa anterior
+                if status in (STATUS_CRC, STATUS_BUSY):
+                    break
+                if status != STATUS_OK:
+                    name = STATUS_NAMES[status] if status < len(STATUS_NAMES) else str(status)
+                    raise BootError("comando 0x%02x recusado: %s" % (command, name))
+                return
+        raise BootError("sem resposta ao comando 0x%02x" % command)
+
+
+def send_image(link, image):
+    if not image or len(image) > SLOT_SIZE:
+        raise BootError("imagem com %d bytes (maximo %d)" % (len(image), SLOT_SIZE))
+
+    # aguarda o bootloader: repete o PING ate ele responder
+    deadline = time.time() + 30
+    while True:
+        try:
+            link.command(CMD_PING, timeout=0.1)
+            break
+        except BootError:
+            if time.time() > deadline:
+                raise
+
+    link.command(CMD_START, struct.pack("<II", len(image), zlib.crc32(image) & 0xFFFFFFFF), timeout=10)
+
+    # o bootloader confirma cada bloco antes de grava-lo: o proximo bloco
+    # trafega enquanto o anterior e gravado
+    for offset in range(0, len(image), CHUNK_SIZE):
+        chunk = image[offset:offset + CHUNK_SIZE]
+        link.command(CMD_DATA, struct.pack("<I", offset) + chunk)
+        sys.stdout.write("\r%d/%d bytes" % (offset + len(chunk), len(image)))
+        sys.stdout.flush()
+    sys.stdout.write("\n")
+
+    # instalacao: copia da aplicacao atual e gravacao da nova. Se a resposta
+    # se perder, o END reenviado recebe o resultado da mesma instalacao
+    link.command(CMD_END, timeout=30)
+    try:
+        link.command(CMD_RUN)
+    except BootError:
+        # a imagem ja esta instalada; sem o RUN a placa segue no bootloader
+        sys.stderr.write("boot_send: sem resposta ao RUN, reinicie a placa se ela nao reiniciar sozinha\n")
+
+
+def request_update(serial_module, port_name, baud):
+    """Pede a aplicacao que reinicie no bootloader."""
+    port = serial_module.Serial(port_name, baud, timeout=0.05)
+    try:
+        port.reset_input_buffer()
+        port.write(APP_UPDATE_COMMAND)
+        port.flush()
+        # resposta, gravacao do pedido na flash e reset
+        time.sleep(APP_RESET_DELAY)
+    finally:
+        port.close()
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Atualiza a aplicacao pelo bootloader serial.")
+    parser.add_argument("port", help="porta serial ligada a UART3")
+    parser.add_argument("image", help="imagem binaria ligada para 0x10000")
+    parser.add_argument("--baud", type=int, default=230400)
+    parser.add_argument("--app-baud", type=int, default=APP_BAUD, help="velocidade do menu da aplicacao")
+    parser.add_argument("--no-request", action="store_true",
+                        help="nao envia o comando 'u'; a placa deve ser reiniciada manualmente")
+    args = parser.parse_args(argv)
+
+    try:
+        import serial
+    except ImportError:
+        sys.stderr.write("boot_send: pyserial nao encontrado (pip install pyserial)\n")
+        return 2
+
+    with open(args.image, "rb") as image_file:
+        image = image_file.read()
+
+    if not args.no_request:
+        request_update(serial, args.port, args.app_baud)
+
+    port = serial.Serial(args.port, args.baud, timeout=0.05)
+    try:
+        send_image(Link(port), image)
+    except BootError as error:
+        sys.stderr.write("boot_send: %s\n" % error)
+        return 1
+    finally:
+        port.close()
+
+    print("imagem instalada, aguardando confirmacao da aplicacao")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,416 @@
+#!/usr/bin/env python3
+"""
+Relatorio de ocupacao de flash e RAM por modulo a partir do arquivo .map
+gerado pelo GNU ld (ex.: Debug/uart2.map).
+
+Cada secao de entrada e atribuida ao objeto que a forneceu (main.o,
+libLib_MCU.a(lpc17xx_uart.o), ...). Secoes alocadas em uma regiao de RAM
+contam como RAM; as que tambem tem endereco de carga em flash (.data)
+contam para os dois.
+
+Uso:
+    map_report.py uart2.map [--flash-budget 64K] [--ram-budget 8K]
+                            [--budget-file orcamento.txt] [--by-archive]
+
+O arquivo de orcamento tem uma linha por modulo: "<modulo> <flash> <ram>",
+com '-' para nao limitar. Linhas iniciadas por '#' sao ignoradas.
+
+Com -flto o mapa atribui todo o codigo do projeto a objetos temporarios
+(/tmp/ccXXXX.ltrans0.ltrans.o). Para recuperar os modulos, informe a imagem
+e os objetos de entrada:
+
+    map_report.py uart2.map --elf uart2.axf --objects src/main.o ...
+
+Cada secao vinda do LTO e atribuida pelo simbolo que contem (nome da secao
+com -ffunction-sections/-fdata-sections, ou simbolos listados no mapa): os
+globais pelo objeto que os define (gcc-nm dos objetos LTO) e as funcoes
+static pelo arquivo fonte da informacao de debug (nm -l da imagem). O que
+nao puder ser atribuido - variaveis static, strings agrupadas (.rodata.str)
+e codigo de varias funcoes na mesma secao - aparece como "*lto*".
+
+Com --vectors ENDERECO, falha tambem se a tabela de vetores (.isr_vector)
+nao estiver nesse endereco: sem referencias em C, o LTO pode descarta-la e
+a imagem, so menor, ainda caberia no orcamento.
+
+Retorna 1 se algum orcamento for excedido ou faltar a tabela de vetores e 2 se o arquivo nao puder ser lido.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+HEX = r"0x[0-9a-fA-F]+"
+
+MEMORY_RE = re.compile(r"^(\S+)\s+(" + HEX + r")\s+(" + HEX + r")\s*(\S*)")
+OUTPUT_RE = re.compile(r"^(\.\S+)(?:\s+(" + HEX + r")\s+(" + HEX + r")(?:\s+load address\s+(" + HEX + r"))?)?\s*$")
+INPUT_RE = re.compile(r"^ (\S+)?\s+(" + HEX + r")\s+(" + HEX + r")\s+(\S.*)$")
+FILL_RE = re.compile(r"^ \*fill\*\s+(" + HEX + r")\s+(" + HEX + r")")
+LONG_RE = re.compile(r"^\s+(" + HEX + r")\s+(" + HEX + r")\s+(?:LONG|SHORT|BYTE|QUAD)\s")
+
+LTRANS_RE = re.compile(r"\.ltrans\d*\.ltrans\.o$|\.ltrans\.o$")
+SYMBOL_LINE_RE = re.compile(r"^\s+(" + HEX + r")\s+([A-Za-z_.$][\w.$]*)\s*$")
+SECTION_SYMBOL_RE = re.compile(r"^\.(?:text|rodata|data|bss|ramfunc)\.(.+)$")
+# sufixos de clones gerados pelo gcc (foo.constprop.0, foo.lto_priv.0, ...)
+CLONE_RE = re.compile(r"\.(?:lto_priv|constprop|isra|part|cold|localalias)(?:\.\d+)?$")
+LTO_MODULE = "*lto*"
+
+# secoes sem SHF_ALLOC: aparecem no mapa com endereco 0 mas nao vao para a memoria
+NOT_ALLOCATED = (".debug", ".comment", ".ARM.attributes", ".stab", ".gnu.attributes")
+
+
+class Region(object):
+    def __init__(self, name, origin, length, attrs):
+        self.name = name
+        self.origin = origin
+        self.length = length
+        self.writable = "w" in attrs
+        self.used = 0
+
+    def contains(self, address):
+        return self.origin <= address < self.origin + self.length
+
+
+class Module(object):
+    def __init__(self, name):
+        self.name = name
+        self.flash = 0
+        self.ram = 0
+
+
+def parse_size(text):
+    """Aceita 4096, 0x1000, 4K ou 1M."""
+    text = text.strip()
+    scale = 1
+    if text[-1:] in ("k", "K"):
+        scale, text = 1024, text[:-1]
+    elif text[-1:] in ("m", "M"):
+        scale, text = 1024 * 1024, text[:-1]
+    return int(text, 0) * scale
+
+
+def module_name(path, by_archive):
+    path = path.strip()
+    match = re.match(r"^(.*\.a)\((.*)\)$", path)
+    if match:
+        archive = os.path.basename(match.group(1))
+        return archive if by_archive else "%s(%s)" % (archive, match.group(2))
+    return os.path.basename(path)
+
+
+def base_symbol(name):
+    previous = None
+    while previous != name:
+        previous = name
+        name = CLONE_RE.sub("", name)
+    return name
+
+
+class LtoResolver(object):
+    """Atribui secoes dos objetos ltrans aos modulos de origem."""
+
+    def __init__(self, globals_by_name=None, functions_by_address=None):
+        self.globals = globals_by_name or {}
+        self.functions = functions_by_address or {}
+
+    def resolve(self, section, address, size, symbols):
+        match = SECTION_SYMBOL_RE.match(section)
+        names = [match.group(1)] if match else []
+        names += [name for (symbol_address, name) in symbols
+                  if address <= symbol_address < address + max(size, 1)]
+        for name in names:
+            module = self.globals.get(base_symbol(name))
+            if module is not None:
+                return module
+        # funcao no inicio da secao; simbolos thumb tem o bit 0 ligado
+        for candidate in (address, address | 1):
+            module = self.functions.get(candidate)
+            if module is not None:
+                return module
+        return LTO_MODULE
+
+
+def run_nm(command):
+    try:
+        output = subprocess.check_output(command, stderr=subprocess.STDOUT)
+    except (OSError, subprocess.CalledProcessError) as error:
+        sys.stderr.write("map_report: aviso: %s: %s\n" % (command[0], error))
+        return []
+    return output.decode("utf-8", "replace").splitlines()
+
+
+def object_module(path):
+    return os.path.basename(path.strip())
+
+
+def source_module(path):
+    return os.path.splitext(os.path.basename(path))[0] + ".o"
+
+
+def load_lto_resolver(nm_prefix, elf, objects):
+    """Le os simbolos dos objetos LTO (gcc-nm) e as funcoes da imagem (nm -l)."""
+    globals_by_name = {}
+    functions_by_address = {}
+
+    if objects:
+        for line in run_nm([nm_prefix + "gcc-nm", "--defined-only", "-A"] + list(objects)):
+            # "src/main.o:00000000 T main"
+            match = re.match(r"^(.*?):\s*[0-9a-fA-F]*\s+[A-Za-z]\s+(\S+)$", line)
+            if match:
+                globals_by_name.setdefault(match.group(2), object_module(match.group(1)))
+
+    if elf:
+        for line in run_nm([nm_prefix + "nm", "-l", "--defined-only", elf]):
+            fields = line.split("\t")
+            parts = fields[0].split()
+            if len(fields) < 2 or len(parts) != 3 or parts[1] not in "tTwW":
+                continue
+            source = fields[1].rsplit(":", 1)[0]
+            functions_by_address[int(parts[0], 16)] = source_module(source)
+
+    return LtoResolver(globals_by_name, functions_by_address)
+
+
+def parse_map(lines, by_archive=False, resolver=None):
+    regions = []
+    modules = {}
+    # secao ltrans aguardando os simbolos listados abaixo dela no mapa
+    lto_section = None
+
+    def region_for(address):
+        for region in regions:
+            if region.contains(address):
+                return region
+        return None
+
+    def account(name, address, size, load):
+        if size == 0:
+            return
+        region = region_for(address)
+        if region is None:
+            return  # secoes de debug e afins nao ocupam memoria
+        module = modules.setdefault(name, Module(name))
+        if region.writable:
+            module.ram += size
+            region.used += size
+            if load is not None:
+                module.flash += size
+                load_region = region_for(load)
+                if load_region is not None:
+                    load_region.used += size
+        else:
+            module.flash += size
+            region.used += size
+
+    def account_input(name, path, address, size, load):
+        nonlocal lto_section
+        flush_lto()
+        if LTRANS_RE.search(path.strip()):
+            if resolver is None:
+                account(LTO_MODULE, address, size, load)
+            else:
+                lto_section = (name, address, size, load, [])
+            return
+        account(module_name(path, by_archive), address, size, load)
+
+    def flush_lto():
+        nonlocal lto_section
+        if lto_section is not None:
+            name, address, size, load, symbols = lto_section
+            lto_section = None
+            account(resolver.resolve(name, address, size, symbols), address, size, load)
+
+    state = "start"
+    section = None
+    load = None
+    pending = None
+
+    for line in lines:
+        line = line.rstrip("\r\n")
+
+        if lto_section is not None:
+            match = SYMBOL_LINE_RE.match(line)
+            if match:
+                lto_section[4].append((int(match.group(1), 16), match.group(2)))
+                continue
+            flush_lto()
+
+        if state == "start":
+            if line.startswith("Memory Configuration"):
+                state = "memory"
+            continue
+
+        if state == "memory":
+            if line.startswith("Linker script and memory map"):
+                state = "map"
+                continue
+            match = MEMORY_RE.match(line)
+            if match and match.group(1) not in ("Name", "*default*"):
+                regions.append(Region(match.group(1), int(match.group(2), 16),
+                                      int(match.group(3), 16), match.group(4)))
+            continue
+
+        # mapa: secoes de saida comecam na coluna 0
+        if line and not line[0].isspace():
+            match = OUTPUT_RE.match(line)
+            if match:
+                section = match.group(1)
+                load = match.group(4)
+                if load is None and match.group(2) is None:
+                    # nome longo: endereco na proxima linha
+                    pending = ("output", section)
+                    continue
+            pending = None
+            continue
+
+        if pending is not None and pending[0] == "output":
+            match = re.match(r"^\s+(" + HEX + r")\s+(" + HEX + r")(?:\s+load address\s+(" + HEX + r"))?", line)
+            pending = None
+            if match:
+                load = match.group(3)
+                continue
+
+        if section is None or section.startswith(NOT_ALLOCATED):
+            continue
+
+        load_address = int(load, 16) if load else None
+
+        match = FILL_RE.match(line)
+        if match:
+            account("*fill*", int(match.group(1), 16), int(match.group(2), 16), load_address)
+            continue
+
+        match = LONG_RE.match(line)
+        if match:
+            account("*linker*", int(match.group(1), 16), int(match.group(2), 16), load_address)
+            continue
+
+        match = INPUT_RE.match(line)
+        if match and match.group(1) is not None:
+            account_input(match.group(1), match.group(4), int(match.group(2), 16),
+                          int(match.group(3), 16), load_address)
+            pending = None
+            continue
+
+        # secao de entrada com nome longo: endereco, tamanho e objeto na proxima linha
+        match = re.match(r"^ (\S+)\s*$", line)
+        if match and not line.startswith(" *"):
+            pending = ("input", match.group(1))
+            continue
+
+        if pending is not None and pending[0] == "input":
+            match = re.match(r"^\s+(" + HEX + r")\s+(" + HEX + r")\s+(\S.*)$", line)
+            if match:
+                account_input(pending[1], match.group(3), int(match.group(1), 16),
+                              int(match.group(2), 16), load_address)
+            pending = None
+
+    flush_lto()
+    return regions, sorted(modules.values(), key=lambda m: (-m.flash, -m.ram, m.name))
+
+
+def find_input_sections(lines, name):
+    """Endereco e tamanho de cada secao de entrada chamada name."""
+    found = []
+    pending = False
+    for line in lines:
+        line = line.rstrip("\r\n")
+        if pending:
+            pending = False
+            match = re.match(r"^\s+(" + HEX + r")\s+(" + HEX + r")\s", line)
+            if match:
+                found.append((int(match.group(1), 16), int(match.group(2), 16)))
+            continue
+        match = INPUT_RE.match(line)
+        if match and match.group(1) == name:
+            found.append((int(match.group(2), 16), int(match.group(3), 16)))
+        elif line.startswith(" ") and line.strip() == name:
+            pending = True  # nome longo: endereco na proxima linha
+    return found
+
+
+def read_budget_file(path):
+    budgets = {}
+    with open(path) as budget_file:
+        for number, line in enumerate(budget_file, 1):
+            line = line.split("#", 1)[0].strip()
+            if not line:
+                continue
+            fields = line.split()
+            if len(fields) != 3:
+                raise ValueError("%s:%d: esperado '<modulo> <flash> <ram>'" % (path, number))
+            limits = [None if field == "-" else parse_size(field) for field in fields[1:]]
+            budgets[fields[0]] = limits
+    return budgets
+
+
+def main(argv):
+    parser = argparse.ArgumentParser(description="Ocupacao de flash/RAM por modulo a partir de um .map do GNU ld.")
+    parser.add_argument("map", help="arquivo .map gerado com -Map")
+    parser.add_argument("--flash-budget", type=parse_size, help="limite total de flash")
+    parser.add_argument("--ram-budget", type=parse_size, help="limite total de RAM (estatica)")
+    parser.add_argument("--budget-file", help="limites por modulo")
+    parser.add_argument("--by-archive", action="store_true", help="agrupa objetos de bibliotecas pelo arquivo .a")
+    parser.add_argument("--elf", help="imagem ligada (com -g), para atribuir funcoes static de builds LTO")
+    parser.add_argument("--objects", nargs="+", default=[], help="objetos de entrada, para atribuir simbolos de builds LTO")
+    parser.add_argument("--vectors", type=lambda text: int(text, 0),
+                        help="endereco esperado da tabela de vetores (.isr_vector)")
+    parser.add_argument("--nm-prefix", default="arm-none-eabi-", help="prefixo do gcc-nm/nm (padrao: arm-none-eabi-)")
+    args = parser.parse_args(argv)
+
+    resolver = None
+    if args.elf or args.objects:
+        resolver = load_lto_resolver(args.nm_prefix, args.elf, args.objects)
+
+    try:
+        with open(args.map) as map_file:
+            lines = map_file.readlines()
+        regions, modules = parse_map(lines, args.by_archive, resolver)
+        budgets = read_budget_file(args.budget_file) if args.budget_file else {}
+    except (IOError, ValueError) as error:
+        sys.stderr.write("map_report: %s\n" % error)
+        return 2
+
+    if not regions:
+        sys.stderr.write("map_report: %s: secao 'Memory Configuration' nao encontrada\n" % args.map)
+        return 2
+
+    width = max([len(m.name) for m in modules] + [6])
+    print("%-*s %8s %8s" % (width, "Modulo", "Flash", "RAM"))
+    for module in modules:
+        print("%-*s %8d %8d" % (width, module.name, module.flash, module.ram))
+    total_flash = sum(m.flash for m in modules)
+    total_ram = sum(m.ram for m in modules)
+    print("%-*s %8d %8d" % (width, "Total", total_flash, total_ram))
+    print("")
+    for region in regions:
+        print("%-12s %8d / %8d bytes (%5.1f%%)" % (region.name, region.used, region.length,
+                                                    100.0 * region.used / region.length))
+
+    failures = []
+    if args.flash_budget is not None and total_flash > args.flash_budget:
+        failures.append("orcamento excedido: flash total %d > %d" % (total_flash, args.flash_budget))
+    if args.ram_budget is not None and total_ram > args.ram_budget:
+        failures.append("orcamento excedido: RAM total %d > %d" % (total_ram, args.ram_budget))
+    if args.vectors is not None:
+        vectors = [size for address, size in find_input_sections(lines, ".isr_vector")
+                   if address == args.vectors]
+        if not vectors or vectors[0] == 0:
+            failures.append("tabela de vetores (.isr_vector) ausente em 0x%x" % args.vectors)
+    by_name = dict((m.name, m) for m in modules)
+    for name, (flash_limit, ram_limit) in sorted(budgets.items()):
+        module = by_name.get(name, Module(name))
+        if flash_limit is not None and module.flash > flash_limit:
+            failures.append("orcamento excedido: %s: flash %d > %d" % (name, module.flash, flash_limit))
+        if ram_limit is not None and module.ram > ram_limit:
+            failures.append("orcamento excedido: %s: RAM %d > %d" % (name, module.ram, ram_limit))
+
+    for failure in failures:
+        sys.stderr.write("map_report: %s\n" % failure)
+
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))